@@ -0,0 +1,61 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_BOUNDINGVOLUME_H
+#define PROG05_BOUNDINGVOLUME_H
+
+#include <algorithm>
+#include <limits>
+#include "Matrix.h"
+
+/// Axis aligned bounding box, empty while min is larger than max
+struct AxisAlignedBox {
+  Vector3d min = Vector3d(std::numeric_limits<double>::infinity());
+  Vector3d max = Vector3d(-std::numeric_limits<double>::infinity());
+  /// whether the box contains no point
+  /// \return
+  bool isEmpty() const {
+    return min(0) > max(0) || min(1) > max(1) || min(2) > max(2);
+  }
+  /// grow the box to contain a point
+  /// \param point
+  void extend(const Vector3d &point) {
+    for (int k = 0; k < 3; k++) {
+      min(k) = std::min(min(k), point(k));
+      max(k) = std::max(max(k), point(k));
+    }
+  }
+  /// grow the box to contain another box
+  /// \param box
+  void extend(const AxisAlignedBox &box) {
+    for (int k = 0; k < 3; k++) {
+      min(k) = std::min(min(k), box.min(k));
+      max(k) = std::max(max(k), box.max(k));
+    }
+  }
+  /// get the center of the box
+  /// \return
+  Vector3d getCenter() const {
+    return (min + max) / 2.;
+  }
+  /// get the squared distance from a point to the nearest point of the box
+  /// \param point
+  /// \return 0 for a point inside the box
+  double getSquaredDistance(const Vector3d &point) const {
+    double squaredDistance = 0.;
+    for (int k = 0; k < 3; k++) {
+      double offset = std::max({min(k) - point(k), point(k) - max(k), 0.});
+      squaredDistance += offset * offset;
+    }
+    return squaredDistance;
+  }
+};
+
+/// Bounding sphere, empty if the radius is negative
+struct BoundingSphere {
+  Vector3d center = Vector3d(0.);
+  double radius = -1.;
+};
+
+#endif //PROG05_BOUNDINGVOLUME_H
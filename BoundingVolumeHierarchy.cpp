@@ -0,0 +1,154 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace {
+enum Classification {
+  OUTSIDE,
+  INTERSECTING,
+  INSIDE
+};
+
+/// classify a box against the planes selected by a mask, removing the planes the box is inside of from the mask
+Classification classifyBox(const AxisAlignedBox &box, const Vector4d *planes, int planeNumber, unsigned int &mask) {
+  if (box.isEmpty()) {
+    return OUTSIDE;
+  }
+  for (int i = 0; i < planeNumber; i++) {
+    if (!(mask & 1u << i)) {
+      continue;
+    }
+    const Vector4d &plane = planes[i];
+    // signed distances of the corners farthest inside and farthest outside of the plane
+    double farthest = plane(3), nearest = plane(3);
+    for (int k = 0; k < 3; k++) {
+      double low = plane(k) * box.min(k), high = plane(k) * box.max(k);
+      farthest += std::max(low, high);
+      nearest += std::min(low, high);
+    }
+    if (farthest < 0.) {
+      return OUTSIDE;
+    }
+    if (nearest >= 0.) {
+      mask &= ~(1u << i);
+    }
+  }
+  return mask == 0 ? INSIDE : INTERSECTING;
+}
+
+/// whether a sphere lies entirely outside of one of the planes selected by a mask
+bool isSphereOutside(const BoundingSphere &sphere, const Vector4d *planes, int planeNumber, unsigned int mask) {
+  for (int i = 0; i < planeNumber; i++) {
+    if (!(mask & 1u << i)) {
+      continue;
+    }
+    const Vector4d &plane = planes[i];
+    double distance = plane(0) * sphere.center(0) + plane(1) * sphere.center(1) + plane(2) * sphere.center(2)
+        + plane(3);
+    if (distance < -sphere.radius) {
+      return true;
+    }
+  }
+  return false;
+}
+}
+
+void BoundingVolumeHierarchy::build(const std::vector<AxisAlignedBox> &boxes,
+                                    const std::vector<BoundingSphere> &spheres) {
+  itemBoxes = boxes;
+  itemSpheres = spheres;
+  items.resize(boxes.size());
+  std::iota(items.begin(), items.end(), 0u);
+  std::vector<Vector3d> centers(boxes.size());
+  for (unsigned long i = 0; i < boxes.size(); i++) {
+    centers[i] = boxes[i].isEmpty() ? Vector3d(0.) : boxes[i].getCenter();
+  }
+  nodes.clear();
+  if (!items.empty()) {
+    nodes.reserve(items.size() * 2);
+    buildNode(0, static_cast<uint32_t>(items.size()), centers);
+  }
+}
+
+uint32_t BoundingVolumeHierarchy::buildNode(uint32_t first, uint32_t end, const std::vector<Vector3d> &centers) {
+  auto index = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  AxisAlignedBox box, centerBox;
+  for (uint32_t i = first; i < end; i++) {
+    if (!itemBoxes[items[i]].isEmpty()) {
+      box.extend(itemBoxes[items[i]]);
+      centerBox.extend(centers[items[i]]);
+    }
+  }
+  nodes[index].box = box;
+  nodes[index].firstItem = first;
+  nodes[index].itemNumber = end - first;
+  nodes[index].secondChild = 0;
+  if (end - first <= LEAF_SIZE) {
+    return index;
+  }
+  int axis = 0;
+  if (!centerBox.isEmpty()) {
+    Vector3d extent = centerBox.max - centerBox.min;
+    axis = extent(1) > extent(axis) ? 1 : axis;
+    axis = extent(2) > extent(axis) ? 2 : axis;
+  }
+  uint32_t middle = first + (end - first) / 2;
+  std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + end,
+                   [&](uint32_t a, uint32_t b) { return centers[a](axis) < centers[b](axis); });
+  buildNode(first, middle, centers);
+  uint32_t second = buildNode(middle, end, centers);
+  nodes[index].secondChild = second;
+  return index;
+}
+
+unsigned long BoundingVolumeHierarchy::cull(const Vector4d *planes, int planeNumber, std::vector<char> &visible) const {
+  visible.assign(items.size(), 0);
+  if (nodes.empty()) {
+    return 0;
+  }
+  unsigned long visibleNumber = 0;
+  std::vector<std::pair<uint32_t, unsigned int>> stack;
+  stack.emplace_back(0, (1u << planeNumber) - 1);
+  while (!stack.empty()) {
+    uint32_t index = stack.back().first;
+    unsigned int mask = stack.back().second;
+    stack.pop_back();
+    const BoundingVolumeNode &node = nodes[index];
+    Classification classification = classifyBox(node.box, planes, planeNumber, mask);
+    if (classification == OUTSIDE) {
+      continue;
+    }
+    if (classification == INSIDE || node.secondChild == 0) {
+      for (uint32_t i = node.firstItem; i < node.firstItem + node.itemNumber; i++) {
+        uint32_t item = items[i];
+        if (classification == INTERSECTING) {
+          unsigned int itemMask = mask;
+          if (isSphereOutside(itemSpheres[item], planes, planeNumber, itemMask)
+              || classifyBox(itemBoxes[item], planes, planeNumber, itemMask) == OUTSIDE) {
+            continue;
+          }
+        }
+        visible[item] = 1;
+        visibleNumber++;
+      }
+      continue;
+    }
+    stack.emplace_back(node.secondChild, mask);
+    stack.emplace_back(index + 1, mask);
+  }
+  return items.size() - visibleNumber;
+}
+
+const std::vector<BoundingVolumeNode> &BoundingVolumeHierarchy::getNodes() const {
+  return nodes;
+}
+
+const std::vector<uint32_t> &BoundingVolumeHierarchy::getItems() const {
+  return items;
+}
@@ -0,0 +1,54 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_BOUNDINGVOLUMEHIERARCHY_H
+#define PROG05_BOUNDINGVOLUMEHIERARCHY_H
+
+#include <cstdint>
+#include <vector>
+#include "BoundingVolume.h"
+
+/// Node of a bounding volume hierarchy. The first child of an inner node directly follows it.
+struct BoundingVolumeNode {
+  AxisAlignedBox box;
+  /// the items of the subtree, which are consecutive in the item order
+  uint32_t firstItem, itemNumber;
+  /// index of the second child, 0 for leaves
+  uint32_t secondChild;
+};
+
+/// Bounding volume hierarchy over the bounding boxes of the scene objects, used to skip whole groups of objects
+/// outside of the view frustum.
+class BoundingVolumeHierarchy {
+ public:
+  /// maximum number of items in a leaf
+  static const uint32_t LEAF_SIZE = 2;
+  /// build the hierarchy by splitting the items at the median center along the longest axis of their centers
+  /// \param boxes bounding box of every item
+  /// \param spheres bounding sphere of every item
+  void build(const std::vector<AxisAlignedBox> &boxes, const std::vector<BoundingSphere> &spheres);
+  /// find the items intersecting a convex volume. Subtrees inside of the volume are accepted without testing their
+  /// items.
+  /// \param planes bounding planes of the volume, a point p is inside if planes[i] . (p, 1) >= 0 for every plane,
+  /// and the first three coefficients of every plane are a unit vector
+  /// \param planeNumber
+  /// \param visible set to 1 for the items intersecting the volume, 0 for the other ones
+  /// \return number of items outside of the volume
+  unsigned long cull(const Vector4d *planes, int planeNumber, std::vector<char> &visible) const;
+  /// get the nodes in depth first order, the first one being the root
+  /// \return
+  const std::vector<BoundingVolumeNode> &getNodes() const;
+  /// get the item indices in the order the nodes refer to
+  /// \return
+  const std::vector<uint32_t> &getItems() const;
+ private:
+  uint32_t buildNode(uint32_t first, uint32_t end, const std::vector<Vector3d> &centers);
+  std::vector<BoundingVolumeNode> nodes;
+  std::vector<AxisAlignedBox> itemBoxes;
+  std::vector<BoundingSphere> itemSpheres;
+  /// item indices, the items of every leaf are consecutive
+  std::vector<uint32_t> items;
+};
+
+#endif //PROG05_BOUNDINGVOLUMEHIERARCHY_H
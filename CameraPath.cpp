@@ -0,0 +1,80 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "CameraPath.h"
+#include <algorithm>
+
+namespace {
+/// evaluate the cubic Hermite curve between two keyframes
+/// \param p1 value at the first keyframe
+/// \param p2 value at the second keyframe
+/// \param m1 derivative at the first keyframe, per frame
+/// \param m2 derivative at the second keyframe, per frame
+/// \param h frames between the keyframes
+/// \param s position between the keyframes in [0, 1]
+Vector3d interpolateHermite(const Vector3d &p1, const Vector3d &p2, const Vector3d &m1, const Vector3d &m2, double h,
+                            double s) {
+  double s2 = s * s;
+  double s3 = s2 * s;
+  return p1 * (2. * s3 - 3. * s2 + 1.) + m1 * ((s3 - 2. * s2 + s) * h) + p2 * (-2. * s3 + 3. * s2)
+      + m2 * ((s3 - s2) * h);
+}
+}
+
+void CameraPath::addKeyframe(int frame, const Camera &camera) {
+  auto position = std::lower_bound(keyframes.begin(), keyframes.end(), frame,
+                                   [](const CameraKeyframe &keyframe, int f) { return keyframe.frame < f; });
+  if (position != keyframes.end() && position->frame == frame) {
+    position->camera = camera;
+  } else {
+    keyframes.insert(position, CameraKeyframe{frame, camera});
+  }
+}
+const std::vector<CameraKeyframe> &CameraPath::getKeyframes() const {
+  return keyframes;
+}
+std::vector<CameraKeyframe> &CameraPath::getKeyframes() {
+  return keyframes;
+}
+bool CameraPath::empty() const {
+  return keyframes.empty();
+}
+int CameraPath::getFrameNumber() const {
+  return keyframes.empty() ? 0 : keyframes.back().frame + 1;
+}
+Camera CameraPath::getCamera(double frame) const {
+  if (frame <= keyframes.front().frame) {
+    return keyframes.front().camera;
+  }
+  if (frame >= keyframes.back().frame) {
+    return keyframes.back().camera;
+  }
+  // keyframes k1 and k2 around the frame, and their neighbors k0 and k3 shaping the tangents
+  auto k2 = static_cast<unsigned long>(std::upper_bound(keyframes.begin(), keyframes.end(), frame,
+                                                        [](double f, const CameraKeyframe &keyframe) {
+                                                          return f < keyframe.frame;
+                                                        }) - keyframes.begin());
+  auto k1 = k2 - 1;
+  auto k0 = k1 == 0 ? k1 : k1 - 1;
+  auto k3 = k2 + 1 == keyframes.size() ? k2 : k2 + 1;
+  const Camera &c1 = keyframes[k1].camera;
+  const Camera &c2 = keyframes[k2].camera;
+  double h = keyframes[k2].frame - keyframes[k1].frame;
+  double s = (frame - keyframes[k1].frame) / h;
+  // Catmull-Rom tangents over uneven keyframe spacing, one-sided at the ends of the path
+  auto getTangent = [this](unsigned long previous, unsigned long next, const Vector3d &(Camera::*get)() const) {
+    return ((keyframes[next].camera.*get)() - (keyframes[previous].camera.*get)())
+        / static_cast<double>(keyframes[next].frame - keyframes[previous].frame);
+  };
+  Camera camera = c1;
+  camera.setEyePosition(interpolateHermite(c1.getEyePosition(), c2.getEyePosition(),
+                                           getTangent(k0, k2, &Camera::getEyePosition),
+                                           getTangent(k1, k3, &Camera::getEyePosition), h, s));
+  camera.setLookAtPosition(interpolateHermite(c1.getLookAtPosition(), c2.getLookAtPosition(),
+                                              getTangent(k0, k2, &Camera::getLookAtPosition),
+                                              getTangent(k1, k3, &Camera::getLookAtPosition), h, s));
+  camera.setUpDirection(c1.getUpDirection() * (1. - s) + c2.getUpDirection() * s);
+  camera.setAngle(c1.getAngle() * (1. - s) + c2.getAngle() * s);
+  return camera;
+}
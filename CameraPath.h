@@ -0,0 +1,47 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_CAMERAPATH_H
+#define PROG05_CAMERAPATH_H
+
+#include <vector>
+#include "Camera.h"
+
+/// Camera of a keyframe of a camera path
+struct CameraKeyframe {
+  /// frame the camera is reached at
+  int frame;
+  Camera camera;
+};
+
+/// Camera animation through keyframes. The eye and look at positions follow Catmull-Rom splines through the
+/// keyframes, the up direction and the angle are interpolated linearly.
+class CameraPath {
+ public:
+  /// add a keyframe, replacing the keyframe of the same frame
+  /// \param frame
+  /// \param camera
+  void addKeyframe(int frame, const Camera &camera);
+  /// get the keyframes, in increasing frame order
+  /// \return
+  const std::vector<CameraKeyframe> &getKeyframes() const;
+  /// get the keyframes, to edit their cameras
+  /// \return
+  std::vector<CameraKeyframe> &getKeyframes();
+  /// whether the path has no keyframe
+  /// \return
+  bool empty() const;
+  /// get the number of frames of the animation, up to the last keyframe
+  /// \return 0 for an empty path
+  int getFrameNumber() const;
+  /// get the camera of a frame, the camera of the nearest keyframe before the first or after the last keyframe.
+  /// The path must not be empty.
+  /// \param frame may fall between two frames
+  /// \return interpolated camera, with the image size and depths of the keyframe before the frame
+  Camera getCamera(double frame) const;
+ private:
+  std::vector<CameraKeyframe> keyframes;
+};
+
+#endif //PROG05_CAMERAPATH_H
@@ -0,0 +1,56 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "Clipper.h"
+#include <cmath>
+
+namespace {
+/// signed distance to the near plane, the depth after the division is 1 on the near plane
+inline Real getNearDistance(const Vector4r &position) {
+  return position(3) - position(2);
+}
+}
+
+void Clipper::getFrustumPlanes(const Matrix4d &m, int width, int height, Vector4d planes[6]) {
+  Vector4d rows[4];
+  for (int i = 0; i < 4; i++) {
+    rows[i] = Vector4d({m(i, 0), m(i, 1), m(i, 2), m(i, 3)});
+  }
+  // the same inequalities as getOutCode(), with the position replaced by the rows of the transformation
+  planes[0] = rows[0] + rows[3] * 0.5;
+  planes[1] = rows[3] * (width - 0.5) - rows[0];
+  planes[2] = rows[1] + rows[3] * 0.5;
+  planes[3] = rows[3] * (height - 0.5) - rows[1];
+  planes[4] = rows[3] - rows[2];
+  planes[5] = rows[2] + rows[3];
+  for (int i = 0; i < 6; i++) {
+    double length = std::sqrt(planes[i](0) * planes[i](0) + planes[i](1) * planes[i](1)
+                                  + planes[i](2) * planes[i](2));
+    planes[i] /= length;
+  }
+}
+
+int Clipper::clipNear(const Vector4r &v0, const Vector4r &v1, const Vector4r &v2, ClipVertex *polygon) {
+  const Vector4r *vertices[3] = {&v0, &v1, &v2};
+  int count = 0;
+  for (int k = 0; k < 3; k++) {
+    const Vector4r &p = *vertices[k];
+    const Vector4r &q = *vertices[(k + 1) % 3];
+    Real dp = getNearDistance(p), dq = getNearDistance(q);
+    if (dp >= 0) {
+      Vector3r weights(0);
+      weights(k) = 1;
+      polygon[count++] = {p, weights};
+    }
+    if ((dp >= 0) != (dq >= 0)) {
+      // the edge crosses the plane, add the intersection
+      Real t = dp / (dp - dq);
+      Vector3r weights(0);
+      weights(k) = 1 - t;
+      weights((k + 1) % 3) = t;
+      polygon[count++] = {p + (q - p) * t, weights};
+    }
+  }
+  return count;
+}
@@ -0,0 +1,86 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_CLIPPER_H
+#define PROG05_CLIPPER_H
+
+#include "Matrix.h"
+
+/// Vertex of a clipped polygon
+struct ClipVertex {
+  /// homogeneous screen space position, w > 0 in front of the camera
+  Vector4r position;
+  /// weights of the vertices of the original triangle
+  Vector3r weights;
+};
+
+/// Frustum tests and clipping of triangles in homogeneous screen space, the space reached by applying the viewport
+/// transformation before the homogeneous division. The viewport covers x in [-0.5, width - 0.5] and y in
+/// [-0.5, height - 0.5] after the division.
+class Clipper {
+ public:
+  /// planes of the view frustum, a bit of an out code is set if a point lies outside of the plane
+  enum OutCode : unsigned int {
+    CLIP_LEFT = 1u,
+    CLIP_RIGHT = 1u << 1,
+    CLIP_BOTTOM = 1u << 2,
+    CLIP_TOP = 1u << 3,
+    CLIP_NEAR = 1u << 4,
+    CLIP_FAR = 1u << 5
+  };
+  /// get the planes of the view frustum a point lies outside of
+  /// \param position homogeneous screen space position
+  /// \param width width of the viewport
+  /// \param height height of the viewport
+  /// \return bitwise or of OutCode values
+  template<typename T>
+  static unsigned int getOutCode(const Matrix<T, 4, 1> &position, int width, int height) {
+    T x = position(0), y = position(1), z = position(2), w = position(3);
+    const T half = 0.5;
+    unsigned int code = 0;
+    if (x < -half * w) {
+      code |= CLIP_LEFT;
+    }
+    if (x > (width - half) * w) {
+      code |= CLIP_RIGHT;
+    }
+    if (y < -half * w) {
+      code |= CLIP_BOTTOM;
+    }
+    if (y > (height - half) * w) {
+      code |= CLIP_TOP;
+    }
+    // the depth after the division is 1 on the near plane
+    if (w - z < T(0)) {
+      code |= CLIP_NEAR;
+    }
+    if (z < -w) {
+      code |= CLIP_FAR;
+    }
+    return code;
+  }
+  /// get the planes of the view frustum in world space, in the order of the OutCode bits
+  /// \param m transformation from world space to homogeneous screen space
+  /// \param width width of the viewport
+  /// \param height height of the viewport
+  /// \param planes resulted planes, a point p is inside if planes[i] . (p, 1) >= 0, with a unit normal
+  static void getFrustumPlanes(const Matrix4d &m, int width, int height, Vector4d planes[6]);
+  /// clip a triangle against the near plane with the Sutherland-Hodgman algorithm
+  /// \param v0 homogeneous screen space vertices of the triangle, at least one in front of the near plane
+  /// \param v1 homogeneous screen space vertices of the triangle, at least one in front of the near plane
+  /// \param v2 homogeneous screen space vertices of the triangle, at least one in front of the near plane
+  /// \param polygon resulted convex polygon, needs room for 4 vertices
+  /// \return number of vertices of the polygon, 3 or 4
+  static int clipNear(const Vector4r &v0, const Vector4r &v1, const Vector4r &v2, ClipVertex *polygon);
+  /// get twice the signed area of a screen space triangle, positive for counterclockwise triangles
+  /// \param v0
+  /// \param v1
+  /// \param v2
+  /// \return
+  static Real getSignedArea(const Vector3r &v0, const Vector3r &v1, const Vector3r &v2) {
+    return (v1(0) - v0(0)) * (v2(1) - v0(1)) - (v2(0) - v0(0)) * (v1(1) - v0(1));
+  }
+};
+
+#endif //PROG05_CLIPPER_H
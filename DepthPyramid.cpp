@@ -0,0 +1,59 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "DepthPyramid.h"
+#include <algorithm>
+
+void DepthPyramid::build(const std::vector<Real> &depth, int width, int height) {
+  levels.resize(1);
+  levels[0].width = width;
+  levels[0].height = height;
+  levels[0].depth = depth;
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    levels.emplace_back();
+    const Level &fine = levels[levels.size() - 2];
+    Level &coarse = levels.back();
+    coarse.width = (fine.width + 1) / 2;
+    coarse.height = (fine.height + 1) / 2;
+    coarse.depth.resize(static_cast<unsigned long>(coarse.width * coarse.height));
+    for (int row = 0; row < coarse.height; row++) {
+      int fineRowEnd = std::min(row * 2 + 2, fine.height);
+      for (int col = 0; col < coarse.width; col++) {
+        int fineColEnd = std::min(col * 2 + 2, fine.width);
+        Real farthest = fine.depth[row * 2 * fine.width + col * 2];
+        for (int r = row * 2; r < fineRowEnd; r++) {
+          for (int c = col * 2; c < fineColEnd; c++) {
+            farthest = std::min(farthest, fine.depth[r * fine.width + c]);
+          }
+        }
+        coarse.depth[row * coarse.width + col] = farthest;
+      }
+    }
+  }
+}
+
+bool DepthPyramid::isOccluded(int rowBegin, int rowEnd, int colBegin, int colEnd, double depth) const {
+  if (levels.empty() || rowBegin >= rowEnd || colBegin >= colEnd) {
+    return false;
+  }
+  // the finest level on which the rectangle spans at most two texels in each direction
+  unsigned long level = 0;
+  while (level + 1 < levels.size()
+      && (((rowEnd - 1) >> level) - (rowBegin >> level) > 1 || ((colEnd - 1) >> level) - (colBegin >> level) > 1)) {
+    level++;
+  }
+  const Level &texels = levels[level];
+  for (int row = rowBegin >> level; row <= (rowEnd - 1) >> level; row++) {
+    for (int col = colBegin >> level; col <= (colEnd - 1) >> level; col++) {
+      if (!(depth < texels.depth[row * texels.width + col])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+unsigned long DepthPyramid::getLevelNumber() const {
+  return levels.size();
+}
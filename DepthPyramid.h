@@ -0,0 +1,39 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_DEPTHPYRAMID_H
+#define PROG05_DEPTHPYRAMID_H
+
+#include <vector>
+#include "Matrix.h"
+
+/// Hierarchical depth buffer. Every texel of a level keeps the farthest depth of the 2 x 2 texels below it, so a
+/// surface nearer than none of the texels covering its screen rectangle is hidden. Larger depths are nearer.
+class DepthPyramid {
+ public:
+  /// build the pyramid from a depth buffer
+  /// \param depth depth of every pixel in row-major order, -infinity for empty pixels
+  /// \param width
+  /// \param height
+  void build(const std::vector<Real> &depth, int width, int height);
+  /// test whether a surface is hidden behind the depth buffer
+  /// \param rowBegin first pixel row of the screen rectangle of the surface
+  /// \param rowEnd one past the last pixel row
+  /// \param colBegin first pixel column
+  /// \param colEnd one past the last pixel column
+  /// \param depth nearest depth of the surface
+  /// \return true if every pixel of the rectangle is nearer than the surface
+  bool isOccluded(int rowBegin, int rowEnd, int colBegin, int colEnd, double depth) const;
+  /// get the number of levels, the first one being the depth buffer itself
+  /// \return
+  unsigned long getLevelNumber() const;
+ private:
+  struct Level {
+    int width, height;
+    std::vector<Real> depth;
+  };
+  std::vector<Level> levels;
+};
+
+#endif //PROG05_DEPTHPYRAMID_H
@@ -0,0 +1,120 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "FramePipeline.h"
+#include "Trace.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+
+FramePipeline::FramePipeline(const std::shared_ptr<Scene> &scene, unsigned int framesInFlight,
+                             unsigned int threadNumber) : scene(scene) {
+  framesInFlight = std::max(1u, framesInFlight);
+  if (threadNumber == 0) {
+    threadNumber = std::max(1u, std::thread::hardware_concurrency() / framesInFlight);
+  }
+  for (unsigned int r = 0; r < framesInFlight; r++) {
+    renderers.emplace_back(new Renderer(scene));
+    renderers.back()->setThreadNumber(threadNumber);
+    renderers.back()->setVerbose(false);
+  }
+}
+unsigned int FramePipeline::getRendererNumber() const {
+  return static_cast<unsigned int>(renderers.size());
+}
+Renderer &FramePipeline::getRenderer(unsigned int index) {
+  return *renderers[index];
+}
+Camera FramePipeline::getFrameCamera(int frame) const {
+  const CameraPath &path = scene->getCameraPath();
+  return path.empty() ? scene->getMainCamera() : path.getCamera(frame);
+}
+void FramePipeline::render(int firstFrame, int endFrame, const FrameHandler &handler) {
+  auto rendererNumber = static_cast<int>(renderers.size());
+  struct FinishedFrame {
+    std::vector<std::shared_ptr<Image8i>> images;
+    RenderStats stats;
+  };
+  // finished frames waiting for the handler, at most one per renderer besides the frames in flight
+  std::map<int, FinishedFrame> finishedFrames;
+  int nextHandledFrame = firstFrame;
+  std::exception_ptr exception;
+  std::mutex mutex;
+  std::condition_variable changed;
+
+  // renderer r renders the frames firstFrame + r, firstFrame + r + rendererNumber, ...
+  auto renderFrames = [&](int r) {
+    Trace::setThreadName("FramePipeline renderer");
+    Renderer &renderer = *renderers[r];
+    for (int frame = firstFrame + r; frame < endFrame; frame += rendererNumber) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return exception || frame < nextHandledFrame + 2 * rendererNumber; });
+        if (exception) {
+          return;
+        }
+      }
+      FinishedFrame finished;
+      try {
+        TRACE_SCOPE("FramePipeline frame");
+        renderer.setCamera(getFrameCamera(frame));
+        renderer.renderForDisplay();
+        for (int policy = 0; policy < Renderer::SHADING_POLICY_NUMBER; policy++) {
+          finished.images.push_back(renderer.getImage(policy));
+        }
+        finished.stats = renderer.getRenderStats();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!exception) {
+          exception = std::current_exception();
+        }
+        changed.notify_all();
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      finishedFrames[frame] = std::move(finished);
+      changed.notify_all();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int r = 0; r < rendererNumber; r++) {
+    threads.emplace_back(renderFrames, r);
+  }
+
+  for (int frame = firstFrame; frame < endFrame; frame++) {
+    FinishedFrame finished;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&] { return exception || finishedFrames.count(frame) != 0; });
+      if (exception) {
+        break;
+      }
+      finished = std::move(finishedFrames[frame]);
+      finishedFrames.erase(frame);
+    }
+    try {
+      TRACE_SCOPE("FramePipeline handler");
+      handler(frame, finished.images, finished.stats);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+      changed.notify_all();
+      break;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    nextHandledFrame = frame + 1;
+    changed.notify_all();
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
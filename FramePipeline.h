@@ -0,0 +1,53 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_FRAMEPIPELINE_H
+#define PROG05_FRAMEPIPELINE_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Renderer.h"
+
+/// Renders the frames of the camera path of a scene with several frames in flight. Every frame in flight has a
+/// renderer of its own sharing the scene, so the vertex stage of a frame runs while the frame before it is shaded,
+/// and finished frames are handed over in order while the next ones render. The renderers keep their buffers from
+/// one frame to the next, and the scene is loaded once.
+class FramePipeline {
+ public:
+  /// number of frames rendered at the same time by default
+  static const unsigned int DEFAULT_FRAMES_IN_FLIGHT = 2;
+  /// receives the images of a finished frame, indexed by the shading policy, nullptr for the policies not rendered,
+  /// and the statistics of its render
+  using FrameHandler = std::function<void(int frame, const std::vector<std::shared_ptr<Image8i>> &images,
+                                          const RenderStats &stats)>;
+  /// Construct the pipeline
+  /// \param scene rendered scene, left unchanged
+  /// \param framesInFlight number of frames rendered at the same time
+  /// \param threadNumber threads rendering each frame, 0 to share the hardware threads between the frames
+  FramePipeline(const std::shared_ptr<Scene> &scene, unsigned int framesInFlight, unsigned int threadNumber);
+  /// get the number of renderers, one per frame in flight
+  /// \return
+  unsigned int getRendererNumber() const;
+  /// get a renderer, to change its settings before rendering. All renderers should have the same settings.
+  /// \param index in [0, getRendererNumber())
+  /// \return
+  Renderer &getRenderer(unsigned int index);
+  /// get the camera of a frame
+  /// \param frame
+  /// \return the camera of the frame on the camera path, the main camera for a scene without camera path
+  Camera getFrameCamera(int frame) const;
+  /// render the frames [firstFrame, endFrame). The handler is called on the calling thread in increasing frame
+  /// order, while the following frames render. The first exception thrown by a renderer or the handler stops the
+  /// rendering and is rethrown here.
+  /// \param firstFrame
+  /// \param endFrame
+  /// \param handler
+  void render(int firstFrame, int endFrame, const FrameHandler &handler);
+ private:
+  std::shared_ptr<Scene> scene;
+  std::vector<std::unique_ptr<Renderer>> renderers;
+};
+
+#endif //PROG05_FRAMEPIPELINE_H
@@ -5,10 +5,27 @@
 #ifndef PROG05_IMAGE_H
 #define PROG05_IMAGE_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
 #include "Color.h"
 using Image32f = Matrix<ColorRGB32f>;
 using Image8i = Matrix<ColorRGB8i>;
 
+/// Differences between two 8-bit images of the same size.
+struct ImageDifference {
+  /// pixels with at least one different channel
+  unsigned long pixels = 0;
+  /// largest difference of a channel
+  int maxChannel = 0;
+  /// peak signal to noise ratio in dB, infinite for identical images
+  double psnr = std::numeric_limits<double>::infinity();
+};
+
 /// Utility class for images
 class ImageUtils {
  public:
@@ -32,15 +49,6 @@ class ImageUtils {
     }
     return result;
   }
-  /// clear image
-  /// \param image original image
-  static void clearImage(Image32f &image) {
-    for (int i = 0; i < image.rows(); i++) {
-      for (int j = 0; j < image.cols(); j++) {
-        image(i, j) = ColorRGB32f({0.f, 0.f, 0.f});
-      }
-    }
-  }
 
   /// get the raw data of an 8-bit image
   /// \param image
@@ -57,6 +65,75 @@ class ImageUtils {
     }
     return data;
   }
+
+  /// write an 8-bit image to a binary PPM file
+  /// \param image
+  /// \param fileName
+  /// \return false if the file cannot be written
+  static bool writePpm(const Image8i &image, const std::string &fileName) {
+    std::ofstream out(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+    out << "P6\n" << image.cols() << " " << image.rows() << "\n255\n";
+    std::unique_ptr<unsigned char[]> data(getRawData(image));
+    auto size = static_cast<std::streamsize>(image.cols() * image.rows() * 3);
+    out.write(reinterpret_cast<const char *>(data.get()), size);
+    out.close();
+    return static_cast<bool>(out);
+  }
+
+  /// read an 8-bit image from a binary PPM file, as written by writePpm()
+  /// \param fileName
+  /// \return nullptr if the file cannot be read or is not a binary PPM file with 255 as maximum value
+  static std::shared_ptr<Image8i> readPpm(const std::string &fileName) {
+    std::ifstream in(fileName, std::ios::in | std::ios::binary);
+    std::string magic;
+    int width = 0, height = 0, maxValue = 0;
+    in >> magic >> width >> height >> maxValue;
+    // a single whitespace character separates the header from the pixels
+    in.get();
+    if (!in || magic != "P6" || width <= 0 || height <= 0 || maxValue != 255) {
+      return nullptr;
+    }
+    std::unique_ptr<unsigned char[]> data(new unsigned char[width * height * 3]);
+    in.read(reinterpret_cast<char *>(data.get()), static_cast<std::streamsize>(width * height * 3));
+    if (!in) {
+      return nullptr;
+    }
+    auto result = std::make_shared<Image8i>();
+    result->resize(height, width);
+    for (int i = 0; i < height; i++) {
+      for (int j = 0; j < width; j++) {
+        auto pos = (i * width + j) * 3;
+        (*result)(i, j) = ColorRGB8i({data[pos], data[pos + 1], data[pos + 2]});
+      }
+    }
+    return result;
+  }
+
+  /// compare two 8-bit images of the same size
+  /// \param image
+  /// \param reference
+  /// \return
+  static ImageDifference compareImages(const Image8i &image, const Image8i &reference) {
+    ImageDifference difference;
+    double squaredErrorSum = 0.;
+    for (unsigned long i = 0; i < image.rows(); i++) {
+      for (unsigned long j = 0; j < image.cols(); j++) {
+        bool different = false;
+        for (int k = 0; k < 3; k++) {
+          int channelDifference = std::abs(image(i, j)(k) - reference(i, j)(k));
+          different = different || channelDifference != 0;
+          difference.maxChannel = std::max(difference.maxChannel, channelDifference);
+          squaredErrorSum += channelDifference * channelDifference;
+        }
+        difference.pixels += different ? 1 : 0;
+      }
+    }
+    if (squaredErrorSum > 0.) {
+      double meanSquaredError = squaredErrorSum / (static_cast<double>(image.rows()) * image.cols() * 3);
+      difference.psnr = 10. * std::log10(255. * 255. / meanSquaredError);
+    }
+    return difference;
+  }
 };
 
 #endif //PROG05_IMAGE_H
@@ -3,9 +3,10 @@
 //
 
 #include "LightSource.h"
+#include <algorithm>
 
-LightSource::LightSource(const Vector3d &position, const ColorRGB32f &intensity) : position(position),
-                                                                                   intensity(intensity) {}
+LightSource::LightSource(const Vector3d &position, const ColorRGB32f &intensity, double radius)
+    : position(position), intensity(intensity), radius(radius) {}
 
 const Vector3d &LightSource::getPosition() const {
   return position;
@@ -21,4 +22,21 @@ const ColorRGB32f &LightSource::getIntensity() const {
 
 void LightSource::setIntensity(const ColorRGB32f &intensity) {
   LightSource::intensity = intensity;
-}
\ No newline at end of file
+}
+
+double LightSource::getRadius() const {
+  return radius;
+}
+
+void LightSource::setRadius(double radius) {
+  LightSource::radius = radius;
+}
+
+double LightSource::getAttenuation(const Vector3d &point) const {
+  if (radius <= 0.) {
+    return 1.;
+  }
+  Vector3d offset = point - position;
+  double window = std::max(1. - offset.dot(offset) / (radius * radius), 0.);
+  return window * window;
+}
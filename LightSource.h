@@ -13,8 +13,10 @@ class LightSource {
   /// Construct a light source using the position and color
   /// \param position
   /// \param intensity color of the light source
+  /// \param radius distance the light reaches, 0 for a light reaching everywhere without attenuation
   LightSource(const Vector3d &position,
-              const ColorRGB32f &intensity);
+              const ColorRGB32f &intensity,
+              double radius = 0.);
 
   /// get the light source position
   /// \return
@@ -32,9 +34,23 @@ class LightSource {
   /// \param intensity
   void setIntensity(const ColorRGB32f &intensity);
 
+  /// get the distance the light reaches
+  /// \return 0 for a light reaching everywhere
+  double getRadius() const;
+
+  /// set the distance the light reaches
+  /// \param radius 0 for a light reaching everywhere without attenuation
+  void setRadius(double radius);
+
+  /// get the factor of the intensity reaching a point, falling smoothly from 1 at the light to 0 at its radius
+  /// \param point
+  /// \return (1 - (distance / radius)^2)^2 inside the radius, 0 outside and 1 for a light reaching everywhere
+  double getAttenuation(const Vector3d &point) const;
+
  private:
   Vector3d position;
   ColorRGB32f intensity;
+  double radius;
 };
 
 #endif //PROG03_INLINEBOOL_LIGHTSOURCE_H
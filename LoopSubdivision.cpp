@@ -0,0 +1,221 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "LoopSubdivision.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+namespace {
+/// levels with fewer faces are subdivided by a single thread
+const unsigned long kParallelFaceNumber = 1ul << 14;
+const unsigned long kChunkSize = 1ul << 12;
+
+/// run task(chunk, begin, end) over consecutive chunks of [0, number), in parallel if a pool is given
+void forEachChunk(ThreadPool *threadPool, unsigned long number,
+                  const std::function<void(unsigned long, unsigned long, unsigned long)> &task) {
+  unsigned long chunkNumber = (number + kChunkSize - 1) / kChunkSize;
+  auto runChunk = [&](unsigned long c) {
+    task(c, c * kChunkSize, std::min(number, (c + 1) * kChunkSize));
+  };
+  if (threadPool == nullptr) {
+    for (unsigned long c = 0; c < chunkNumber; c++) {
+      runChunk(c);
+    }
+  } else {
+    threadPool->parallelFor(chunkNumber, runChunk);
+  }
+}
+
+/// position of a half edge in the order the half edges of a face are visited: the last one, then the first two
+inline int32_t getVisitRank(int32_t halfEdge) {
+  return halfEdge - halfEdge % 3 + (halfEdge % 3 + 1) % 3;
+}
+
+/// whether a half edge creates the new vertex of its edge, which happens for the half edge visited first
+inline bool isEdgeOwner(const std::vector<int32_t> &opposites, int32_t halfEdge) {
+  int32_t opposite = opposites[halfEdge];
+  return opposite < 0 || opposites[opposite] != halfEdge || getVisitRank(halfEdge) < getVisitRank(opposite);
+}
+
+/// child half edge from the start vertex of a half edge to its new vertex
+inline int32_t getFirstHalf(int32_t halfEdge) {
+  return 3 * (4 * (halfEdge / 3) + halfEdge % 3) + 1;
+}
+
+/// child half edge from the new vertex of a half edge to its end vertex
+inline int32_t getSecondHalf(int32_t halfEdge) {
+  return 3 * (4 * (halfEdge / 3) + (halfEdge + 1) % 3);
+}
+
+/// child half edge of the center face starting at the new vertex of a half edge
+inline int32_t getCenterHalfEdge(int32_t halfEdge) {
+  return 3 * (4 * (halfEdge / 3) + 3) + (halfEdge + 1) % 3;
+}
+
+Vector3d getEdgePosition(const SubdivisionLevel &mesh, int32_t halfEdge) {
+  const auto &positions = mesh.positions;
+  const Vector3d &u = positions[MeshTopology::getStartVertex(mesh.faces, halfEdge)];
+  const Vector3d &v = positions[MeshTopology::getEndVertex(mesh.faces, halfEdge)];
+  int32_t opposite = mesh.adjacency.opposites[halfEdge];
+  if (opposite < 0) {
+    return (u + v) / 2.;
+  }
+  const Vector3d &w = positions[MeshTopology::getStartVertex(mesh.faces, MeshTopology::getPreviousHalfEdge(halfEdge))];
+  const Vector3d &x = positions[MeshTopology::getStartVertex(mesh.faces, MeshTopology::getPreviousHalfEdge(opposite))];
+  return u * 3. / 8. + v * 3. / 8. + w / 8. + x / 8.;
+}
+
+Vector3d getVertexPosition(const SubdivisionLevel &mesh, unsigned long vertex) {
+  const auto &opposites = mesh.adjacency.opposites;
+  const Vector3d &position = mesh.positions[vertex];
+  int32_t first = mesh.vertexHalfEdges[vertex];
+  if (first < 0) {
+    return position;
+  }
+  // count the neighbors by walking around the vertex, a walk not returning to the start meets the boundary
+  auto maxValence = static_cast<unsigned long>(opposites.size());
+  unsigned long valence = 0;
+  int32_t halfEdge = first, last;
+  do {
+    valence++;
+    last = halfEdge;
+    halfEdge = opposites[MeshTopology::getPreviousHalfEdge(halfEdge)];
+  } while (halfEdge >= 0 && halfEdge != first && valence <= maxValence);
+  if (valence > maxValence) {
+    return position;
+  }
+  if (halfEdge < 0) {
+    // the two neighbors along the boundary
+    const Vector3d &a = mesh.positions[MeshTopology::getStartVertex(mesh.faces,
+                                                                    MeshTopology::getPreviousHalfEdge(last))];
+    halfEdge = first;
+    for (unsigned long step = 0; opposites[halfEdge] >= 0 && step <= maxValence; step++) {
+      halfEdge = MeshTopology::getNextHalfEdge(opposites[halfEdge]);
+    }
+    const Vector3d &b = mesh.positions[MeshTopology::getEndVertex(mesh.faces, halfEdge)];
+    return position * (3. / 4.) + (a + b) / 8.;
+  }
+  double beta = 3. / (8. * valence);
+  if (valence == 3) {
+    beta = 3. / 16.;
+  }
+  Vector3d result = position * (1 - valence * beta);
+  halfEdge = first;
+  do {
+    result += mesh.positions[MeshTopology::getEndVertex(mesh.faces, halfEdge)] * beta;
+    halfEdge = opposites[MeshTopology::getPreviousHalfEdge(halfEdge)];
+  } while (halfEdge != first);
+  return result;
+}
+
+void subdivideLevel(const SubdivisionLevel &coarse, const SubdivisionLevelSize &coarseSize,
+                    SubdivisionLevel &fine, ThreadPool *threadPool) {
+  const auto &opposites = coarse.adjacency.opposites;
+  unsigned long faceNumber = coarseSize.faceNumber;
+
+  // number the new vertices: count the edges owned by every chunk of faces, then fill the chunks at their offsets
+  std::vector<unsigned long> chunkOffsets((faceNumber + kChunkSize - 1) / kChunkSize + 1, 0);
+  forEachChunk(threadPool, faceNumber, [&](unsigned long c, unsigned long begin, unsigned long end) {
+    unsigned long owned = 0;
+    for (auto h = static_cast<int32_t>(begin * 3); h < static_cast<int32_t>(end * 3); h++) {
+      owned += isEdgeOwner(opposites, h);
+    }
+    chunkOffsets[c + 1] = owned;
+  });
+  chunkOffsets[0] = coarseSize.vertexNumber;
+  for (unsigned long c = 1; c < chunkOffsets.size(); c++) {
+    chunkOffsets[c] += chunkOffsets[c - 1];
+  }
+  std::vector<int32_t> edgeVertices(faceNumber * 3);
+  forEachChunk(threadPool, faceNumber, [&](unsigned long c, unsigned long begin, unsigned long end) {
+    auto vertex = static_cast<int32_t>(chunkOffsets[c]);
+    for (auto t = static_cast<int32_t>(begin); t < static_cast<int32_t>(end); t++) {
+      for (int32_t h: {3 * t + 2, 3 * t, 3 * t + 1}) {
+        if (isEdgeOwner(opposites, h)) {
+          int32_t opposite = opposites[h];
+          bool paired = opposite >= 0 && opposites[opposite] == h;
+          edgeVertices[h] = vertex;
+          fine.positions[vertex] = getEdgePosition(coarse, h);
+          fine.vertexHalfEdges[vertex] = getCenterHalfEdge(paired ? std::max(h, opposite) : h);
+          vertex++;
+        }
+      }
+    }
+  });
+
+  // split the faces, the children of every half edge are paired with the children of its opposite
+  forEachChunk(threadPool, faceNumber, [&](unsigned long, unsigned long begin, unsigned long end) {
+    for (auto t = static_cast<int32_t>(begin); t < static_cast<int32_t>(end); t++) {
+      for (int32_t h = 3 * t; h < 3 * t + 3; h++) {
+        if (!isEdgeOwner(opposites, h)) {
+          edgeVertices[h] = edgeVertices[opposites[h]];
+        }
+      }
+      const Vector3i &face = coarse.faces[t];
+      int32_t m0 = edgeVertices[3 * t], m1 = edgeVertices[3 * t + 1], m2 = edgeVertices[3 * t + 2];
+      fine.faces[4 * t] = Vector3i({m2, face(0), m0});
+      fine.faces[4 * t + 1] = Vector3i({m0, face(1), m1});
+      fine.faces[4 * t + 2] = Vector3i({m1, face(2), m2});
+      fine.faces[4 * t + 3] = Vector3i({m2, m0, m1});
+      for (int32_t h = 3 * t; h < 3 * t + 3; h++) {
+        int32_t opposite = opposites[h];
+        fine.adjacency.opposites[getFirstHalf(h)] = opposite < 0 ? -1 : getSecondHalf(opposite);
+        fine.adjacency.opposites[getSecondHalf(h)] = opposite < 0 ? -1 : getFirstHalf(opposite);
+      }
+      for (int32_t j = 0; j < 3; j++) {
+        fine.adjacency.opposites[3 * (4 * t + j) + 2] = 3 * (4 * t + 3) + j;
+        fine.adjacency.opposites[3 * (4 * t + 3) + j] = 3 * (4 * t + j) + 2;
+      }
+    }
+  });
+
+  // move the old vertices
+  forEachChunk(threadPool, coarseSize.vertexNumber, [&](unsigned long, unsigned long begin, unsigned long end) {
+    for (unsigned long v = begin; v < end; v++) {
+      fine.positions[v] = getVertexPosition(coarse, v);
+      int32_t halfEdge = coarse.vertexHalfEdges[v];
+      fine.vertexHalfEdges[v] = halfEdge < 0 ? -1 : getFirstHalf(halfEdge);
+    }
+  });
+  fine.adjacency.boundaryEdgeNumber = coarse.adjacency.boundaryEdgeNumber * 2;
+  fine.adjacency.nonManifoldEdgeNumber = coarse.adjacency.nonManifoldEdgeNumber * 2;
+}
+}
+
+void LoopSubdivision::getLevelSizes(const SubdivisionLevel &mesh, unsigned int levels,
+                                    std::vector<SubdivisionLevelSize> &sizes) {
+  SubdivisionLevelSize size{mesh.positions.size(), mesh.faces.size(), 0};
+  for (auto h = 0; h < static_cast<int32_t>(mesh.adjacency.opposites.size()); h++) {
+    size.edgeNumber += isEdgeOwner(mesh.adjacency.opposites, h);
+  }
+  sizes.assign(1, size);
+  for (unsigned int level = 0; level < levels; level++) {
+    // every edge is split in two and every face adds three inner edges
+    size = {size.vertexNumber + size.edgeNumber, size.faceNumber * 4, size.edgeNumber * 2 + size.faceNumber * 3};
+    sizes.push_back(size);
+  }
+}
+
+void LoopSubdivision::subdivide(const SubdivisionLevel &mesh, unsigned int levels,
+                                std::vector<SubdivisionLevel> &results, unsigned int threadNumber) {
+  std::vector<SubdivisionLevelSize> sizes;
+  getLevelSizes(mesh, levels, sizes);
+  results.resize(levels);
+  for (unsigned int level = 0; level < levels; level++) {
+    auto &result = results[level];
+    result.positions.resize(sizes[level + 1].vertexNumber);
+    result.vertexHalfEdges.resize(sizes[level + 1].vertexNumber);
+    result.faces.resize(sizes[level + 1].faceNumber);
+    result.adjacency.opposites.resize(sizes[level + 1].faceNumber * 3);
+  }
+  std::unique_ptr<ThreadPool> threadPool;
+  for (unsigned int level = 0; level < levels; level++) {
+    if (!threadPool && sizes[level].faceNumber >= kParallelFaceNumber && threadNumber != 1) {
+      threadPool.reset(new ThreadPool(threadNumber));
+    }
+    subdivideLevel(level == 0 ? mesh : results[level - 1], sizes[level], results[level], threadPool.get());
+  }
+}
@@ -0,0 +1,52 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_LOOPSUBDIVISION_H
+#define PROG05_LOOPSUBDIVISION_H
+
+#include <vector>
+#include "Matrix.h"
+#include "MeshTopology.h"
+
+/// One level of a Loop subdivided triangle mesh
+struct SubdivisionLevel {
+  std::vector<Vector3d> positions;
+  std::vector<Vector3i> faces;
+  HalfEdgeAdjacency adjacency;
+  /// the half edge every vertex ring is walked from, see MeshTopology::findVertexHalfEdges()
+  std::vector<int32_t> vertexHalfEdges;
+};
+
+/// Element counts of one subdivision level
+struct SubdivisionLevelSize {
+  unsigned long vertexNumber;
+  unsigned long faceNumber;
+  /// number of edges, counting the two half edges of an interior edge once
+  unsigned long edgeNumber;
+};
+
+/// Loop subdivision working directly on the index arrays of a mesh.
+///
+/// Every level splits each edge at a new vertex and each face into four. The new vertices are numbered after the old
+/// ones in the order their edges are first met when visiting the faces in order, and the four children of face t are
+/// the faces 4t to 4t + 3, so the half edge pairing of a level follows from the one of the previous level without any
+/// search. Vertices on boundary edges use the boundary rules of Loop's scheme.
+class LoopSubdivision {
+ public:
+  /// compute the element counts of the given mesh and of every subdivision level
+  /// \param mesh
+  /// \param levels number of subdivision levels
+  /// \param sizes resulted counts, levels + 1 entries starting with the given mesh
+  static void getLevelSizes(const SubdivisionLevel &mesh, unsigned int levels,
+                            std::vector<SubdivisionLevelSize> &sizes);
+  /// subdivide a mesh several times. Large meshes are processed by several threads.
+  /// \param mesh the mesh to subdivide
+  /// \param levels number of subdivision levels
+  /// \param results resulted meshes, one per level, the last one being the finest
+  /// \param threadNumber maximum number of threads, 0 uses all hardware threads
+  static void subdivide(const SubdivisionLevel &mesh, unsigned int levels, std::vector<SubdivisionLevel> &results,
+                        unsigned int threadNumber = 0);
+};
+
+#endif //PROG05_LOOPSUBDIVISION_H
@@ -0,0 +1,67 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &fileName) : data(nullptr), size(0), open(false), mapped(false) {
+#ifdef MAPPED_FILE_POSIX
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat status{};
+    if (fstat(fd, &status) == 0) {
+      open = true;
+      size = static_cast<unsigned long>(status.st_size);
+      if (size > 0) {
+        void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+          madvise(address, size, MADV_SEQUENTIAL);
+          data = static_cast<const char *>(address);
+          mapped = true;
+        } else {
+          open = false;
+        }
+      }
+    }
+    close(fd);
+    if (open) {
+      return;
+    }
+  }
+#endif
+  std::ifstream fin(fileName, std::ios::binary | std::ios::ate);
+  if (!fin.good()) {
+    return;
+  }
+  size = static_cast<unsigned long>(fin.tellg());
+  buffer.resize(size);
+  fin.seekg(0);
+  fin.read(buffer.data(), static_cast<std::streamsize>(size));
+  data = buffer.data();
+  open = true;
+}
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_POSIX
+  if (mapped) {
+    munmap(const_cast<char *>(data), size);
+  }
+#endif
+}
+bool MappedFile::isOpen() const {
+  return open;
+}
+const char *MappedFile::getData() const {
+  return data;
+}
+unsigned long MappedFile::getSize() const {
+  return size;
+}
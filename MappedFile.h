@@ -0,0 +1,38 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_MAPPEDFILE_H
+#define PROG05_MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+
+/// Read-only view of a whole file. The file is memory mapped where the platform supports it and read into memory
+/// otherwise.
+class MappedFile {
+ public:
+  /// map a file
+  /// \param fileName
+  explicit MappedFile(const std::string &fileName);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+  /// whether the file could be opened
+  /// \return
+  bool isOpen() const;
+  /// get the first byte of the file
+  /// \return
+  const char *getData() const;
+  /// get the file size in bytes
+  /// \return
+  unsigned long getSize() const;
+ private:
+  const char *data;
+  unsigned long size;
+  bool open;
+  bool mapped;
+  std::vector<char> buffer;
+};
+
+#endif //PROG05_MAPPEDFILE_H
@@ -10,50 +10,103 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <type_traits>
+
+/// Element storage of a matrix. Fixed sized matrices keep their elements inline, so constructing, copying and
+/// returning them by value never touches the heap.
+/// \tparam T Scalar data type
+/// \tparam Rows Number of Rows of the matrix
+/// \tparam Cols Number of Columns of the matrix
+/// \tparam Dynamic whether the size is only known at run time
+template<typename T, unsigned long Rows, unsigned long Cols, bool Dynamic = (Rows == 0 || Cols == 0)>
+class MatrixStorage {
+ public:
+  constexpr MatrixStorage() : data{} {}
+
+  constexpr unsigned long rows() const { return Rows; }
+
+  constexpr unsigned long cols() const { return Cols; }
+
+  constexpr unsigned long size() const { return Rows * Cols; }
+
+ protected:
+  void resizeStorage(unsigned long, unsigned long, const T &) {
+    throw std::logic_error("fixed sized matrices cannot be resized.");
+  }
+
+  T data[Rows * Cols];
+};
+
+/// Element storage of a dynamic sized matrix, backed by a heap allocated vector.
+template<typename T, unsigned long Rows, unsigned long Cols>
+class MatrixStorage<T, Rows, Cols, true> {
+ public:
+  MatrixStorage() : data(Rows * Cols), height(Rows), width(Cols) {}
+
+  unsigned long rows() const { return height; }
+
+  unsigned long cols() const { return width; }
+
+  unsigned long size() const { return data.size(); }
+
+ protected:
+  void resizeStorage(unsigned long rows, unsigned long cols, const T &val) {
+    height = rows;
+    width = cols;
+    data.resize(height * width, val);
+  }
+
+  std::vector<T> data;
+  unsigned long height, width;
+};
 
 /// Matrix class for both matrices and vectors
+///
+/// Element accessors are only bounds checked in debug builds (NDEBUG not defined).
 /// \tparam T Scalar data type
 /// \tparam Rows Number of Rows of the matrix, 0 for dynamic sized matrices
 /// \tparam Cols Number of Columns of the matrix, 0 for dynamic sized matrices
 template<typename T, unsigned long Rows = 0, unsigned long Cols = 0>
-class Matrix {
+class Matrix : public MatrixStorage<T, Rows, Cols> {
+  using Storage = MatrixStorage<T, Rows, Cols>;
+  using Storage::data;
+
  public:
-  explicit Matrix();
+  constexpr Matrix();
 
   /// construct with an initial value for all elements.
   /// \param initialValue
-  explicit Matrix(T initialValue);
+  constexpr explicit Matrix(T initialValue);
 
   /// construct with an initializer list, useful for vector construction.
   /// \param initializer
-  Matrix(std::initializer_list<T> initializer);
-//  ~Matrix();
+  constexpr Matrix(std::initializer_list<T> initializer);
 
   /// copy constructor
   /// \param rhs
-  Matrix(const Matrix<T, Rows, Cols> &rhs);
+  Matrix(const Matrix<T, Rows, Cols> &rhs) = default;
 
   /// get the element of the ith row and jth column.
   /// \param i
   /// \param j
   /// \return
-  const T &operator()(int i, int j) const;
+  constexpr const T &operator()(int i, int j) const;
 
   /// get the element of the ith row and jth column.
   /// \param i
   /// \param j
   /// \return
-  T &operator()(int i, int j);
+  constexpr T &operator()(int i, int j);
 
   /// only for vectors (one column matrices), get the element of the ith row.
   /// \param i
   /// \return
-  const T &operator()(int i) const;
+  constexpr const T &operator()(int i) const;
 
   /// only for vectors (one column matrices), get the element of the ith row.
   /// \param i
   /// \return
-  T &operator()(int i);
+  constexpr T &operator()(int i);
 
   /// resize the matrix. Only valid for dynamic size matrices.
   /// \param rows
@@ -70,95 +123,95 @@ class Matrix {
   /// assignment operator
   /// \param rhs
   /// \return
-  Matrix &operator=(Matrix rhs);
+  Matrix &operator=(const Matrix &rhs) = default;
 
   /// matrix production
   /// \tparam RhsCols number right operand columns. Need to be the same with the number of rows of the left operand.
   /// \param rhs
   /// \return
   template<unsigned long RhsCols>
-  Matrix<T, Rows, RhsCols> operator*(const Matrix<T, Cols, RhsCols> &rhs) const;
+  constexpr Matrix<T, Rows, RhsCols> operator*(const Matrix<T, Cols, RhsCols> &rhs) const;
 
   /// scalar production
   /// \tparam U scalar data type
   /// \param rhs
   /// \return
   template<typename U>
-  const Matrix operator*(const U &rhs) const;
+  constexpr const Matrix operator*(const U &rhs) const;
 
   /// scalar plus assign
   /// \tparam U scalar data type
   /// \param rhs
   /// \return
   template<typename U>
-  Matrix &operator*=(const U &rhs);
+  constexpr Matrix &operator*=(const U &rhs);
 
   /// scalar division
   /// \tparam U scalar data type
   /// \param rhs
   /// \return
   template<typename U>
-  const Matrix operator/(const U &rhs) const;
+  constexpr const Matrix operator/(const U &rhs) const;
 
   /// scalar divide assign
   /// \tparam U scalar data type
   /// \param rhs
   /// \return
   template<typename U>
-  Matrix &operator/=(const U &rhs);
+  constexpr Matrix &operator/=(const U &rhs);
 
   /// scalar addition
   /// \tparam U scalar data type
   /// \param rhs
   /// \return
   template<typename U>
-  const Matrix operator+(const U &rhs) const;
+  constexpr const Matrix operator+(const U &rhs) const;
 
   /// scalar plus assign
   /// \tparam U scalar data type
   /// \param rhs
   /// \return
   template<typename U>
-  Matrix &operator+=(const U &rhs);
+  constexpr Matrix &operator+=(const U &rhs);
 
   /// scalar subtraction
   /// \tparam U
   /// \param rhs
   /// \return
   template<typename U>
-  const Matrix operator-(const U &rhs) const;
+  constexpr const Matrix operator-(const U &rhs) const;
 
   /// scalar minus assign
   /// \tparam U
   /// \param rhs
   /// \return
   template<typename U>
-  Matrix &operator-=(const U &rhs);
+  constexpr Matrix &operator-=(const U &rhs);
 
   /// matrix addition
   /// \param rhs
   /// \return
-  const Matrix operator+(const Matrix &rhs) const;
+  constexpr const Matrix operator+(const Matrix &rhs) const;
 
   /// matrix plus assign
   /// \param rhs
   /// \return
-  Matrix &operator+=(const Matrix &rhs);
+  constexpr Matrix &operator+=(const Matrix &rhs);
 
   /// matrix subtraction
   /// \param rhs
   /// \return
-  const Matrix operator-(const Matrix &rhs) const;
+  constexpr const Matrix operator-(const Matrix &rhs) const;
 
   /// matrix minus assign
   /// \param rhs
   /// \return
-  Matrix &operator-=(const Matrix &rhs);
+  constexpr Matrix &operator-=(const Matrix &rhs);
 
   /// coefficient wise product
   /// \param rhs
   /// \return
-  const Matrix cwiseProduct(const Matrix &rhs) const;
+  constexpr const Matrix cwiseProduct(const Matrix &rhs) const;
 
   /// l2 norm
   /// \return
@@ -172,14 +225,6 @@ class Matrix {
   /// \return
   const Matrix normalize() const;
 
-  /// get number of rows
-  /// \return
-  unsigned long rows() const;
-
-  /// get number colomns
-  /// \return
-  unsigned long cols() const;
-
   /// print the matrix
   /// \param os
   void print(std::ostream &os) const;
@@ -187,74 +232,111 @@ class Matrix {
   /// cross product. Only valid for vectors.
   /// \param rhs
   /// \return
-  const Matrix cross(const Matrix &rhs) const;
+  constexpr const Matrix cross(const Matrix &rhs) const;
 
   /// dot product. Only valid for vectors.
   /// \param rhs
   /// \return
-  T dot(const Matrix &rhs) const;
+  constexpr T dot(const Matrix &rhs) const;
 
   /// return the raw pointer to the start of the chunk of the raw data.
   /// \return
   T *getRawData();
 
+  /// return the raw pointer to the start of the chunk of the raw data.
+  /// \return
+  const T *getRawData() const;
+
+  /// convert the elements to another scalar type
+  /// \tparam U scalar data type of the result
+  /// \return
+  template<typename U>
+  Matrix<U, Rows, Cols> cast() const;
+
  private:
-  std::vector<T> data;
-  unsigned long width, height;
+  constexpr void checkSize(const Matrix &rhs) const;
 };
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols>::Matrix() : width(Cols), height(Rows) {
-  data = std::vector<T>(Rows * Cols, T(0));
-}
+constexpr Matrix<T, Rows, Cols>::Matrix() : Storage() {}
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols>::Matrix(T initialValue) : width(Cols), height(Rows) {
-  data = std::vector<T>(Rows * Cols, initialValue);
+constexpr Matrix<T, Rows, Cols>::Matrix(T initialValue) : Storage() {
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] = initialValue;
+  }
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-unsigned long Matrix<T, Rows, Cols>::rows() const {
-  return height;
+constexpr Matrix<T, Rows, Cols>::Matrix(std::initializer_list<T> initializer) : Storage() {
+  if (initializer.size() != Rows * Cols) {
+    throw std::logic_error("wrong initializer list size.");
+  }
+  unsigned long i = 0;
+  for (const auto &value: initializer) {
+    data[i++] = value;
+  }
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-unsigned long Matrix<T, Rows, Cols>::cols() const {
-  return width;
+constexpr const T &Matrix<T, Rows, Cols>::operator()(int i, int j) const {
+#ifndef NDEBUG
+  if (i >= this->rows() || j >= this->cols() || i < 0 || j < 0) {
+    throw std::out_of_range("index out of bounds");
+  }
+#endif
+  return data[i * this->cols() + j];
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-const T &Matrix<T, Rows, Cols>::operator()(int i, int j) const {
-  if (i >= height || j >= width || i < 0 || j < 0) {
+constexpr T &Matrix<T, Rows, Cols>::operator()(int i, int j) {
+#ifndef NDEBUG
+  if (i >= this->rows() || j >= this->cols() || i < 0 || j < 0) {
     throw std::out_of_range("index out of bounds");
   }
-  return data[i * width + j];
+#endif
+  return data[i * this->cols() + j];
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-T &Matrix<T, Rows, Cols>::operator()(int i, int j) {
-  return const_cast<T &>((*static_cast<const Matrix<T, Rows, Cols> *>(this))(i, j));
+constexpr const T &Matrix<T, Rows, Cols>::operator()(int i) const {
+  static_assert(Cols == 1, "use both row and col for matrix indexing.");
+  return (*this)(i, 0);
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-template<unsigned long RhsCols>
-Matrix<T, Rows, RhsCols> Matrix<T, Rows, Cols>::operator*(const Matrix<T, Cols, RhsCols> &rhs) const {
+constexpr T &Matrix<T, Rows, Cols>::operator()(int i) {
+  static_assert(Cols == 1, "use both row and col for matrix indexing.");
+  return (*this)(i, 0);
+}
+
+template<typename T, unsigned long Rows, unsigned long Cols>
+constexpr void Matrix<T, Rows, Cols>::checkSize(const Matrix &rhs) const {
+  if (this->rows() != rhs.rows() || this->cols() != rhs.cols()) {
+    throw std::logic_error("wrong matrix sizes.");
+  }
+}
 
-  if (width != rhs.rows()) {
+template<typename T, unsigned long Rows, unsigned long Cols>
+template<unsigned long RhsCols>
+constexpr Matrix<T, Rows, RhsCols> Matrix<T, Rows, Cols>::operator*(const Matrix<T, Cols, RhsCols> &rhs) const {
+  if (this->cols() != rhs.rows()) {
     throw std::logic_error("wrong matrix sizes");
   }
 
-  Matrix<T, Rows, RhsCols> res(0);
+  Matrix<T, Rows, RhsCols> res(T(0));
 
   if (Rows == 0 && RhsCols == 0) {
-    res.resize(height, rhs.cols());
+    res.resize(this->rows(), rhs.cols(), T(0));
   }
 
-  for (int i = 0; i < height; i++) {
-    for (int j = 0; j < rhs.cols(); j++) {
-      for (int k = 0; k < width; k++) {
-        res(i, j) += (*this)(i, k) * rhs(k, j);
+  for (unsigned long i = 0; i < this->rows(); i++) {
+    for (unsigned long j = 0; j < rhs.cols(); j++) {
+      T sum(0);
+      for (unsigned long k = 0; k < this->cols(); k++) {
+        sum += (*this)(i, k) * rhs(k, j);
       }
+      res(i, j) = sum;
     }
   }
 
@@ -263,8 +345,8 @@ Matrix<T, Rows, RhsCols> Matrix<T, Rows, Cols>::operator*(const Matrix<T, Cols,
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 void Matrix<T, Rows, Cols>::print(std::ostream &os) const {
-  for (int i = 0; i < height; i++) {
-    for (int j = 0; j < width; j++) {
+  for (int i = 0; i < this->rows(); i++) {
+    for (int j = 0; j < this->cols(); j++) {
       os << (*this)(i, j) << " ";
     }
     os << std::endl;
@@ -272,90 +354,57 @@ void Matrix<T, Rows, Cols>::print(std::ostream &os) const {
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator+(const Matrix<T, Rows, Cols> &rhs) const {
-  if (height != rhs.rows() || width != rhs.cols()) {
-    throw std::logic_error("wrong matrix sizes");
-  }
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator+(const Matrix<T, Rows, Cols> &rhs) const {
   Matrix<T, Rows, Cols> res(*this);
-  for (int i = 0; i < res.data.size(); i++) {
-    res.data[i] += rhs.data[i];
-  }
+  res += rhs;
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols>::Matrix(const Matrix<T, Rows, Cols> &rhs) : width(rhs.cols()), height(rhs.rows()),
-                                                                  data(rhs.data) {}
-
-template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator=(const Matrix<T, Rows, Cols> rhs) {
-  height = rhs.rows();
-  width = rhs.cols();
-  data = rhs.data;
-
-  return *this;
-}
-
-template<typename T, unsigned long Rows, unsigned long Cols>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator-(const Matrix<T, Rows, Cols> &rhs) const {
-  if (height != rhs.rows() || width != rhs.cols()) {
-    throw std::logic_error("wrong matrix sizes");
-  }
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator-(const Matrix<T, Rows, Cols> &rhs) const {
   Matrix<T, Rows, Cols> res(*this);
-  for (int i = 0; i < res.data.size(); i++) {
-    res.data[i] -= rhs.data[i];
-  }
+  res -= rhs;
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator*(const U &rhs) const {
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator*(const U &rhs) const {
   Matrix<T, Rows, Cols> res(*this);
-  for (int i = 0; i < res.data.size(); i++) {
-    res.data[i] *= rhs;
-  }
+  res *= rhs;
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator/(const U &rhs) const {
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator/(const U &rhs) const {
   Matrix<T, Rows, Cols> res(*this);
-  for (int i = 0; i < res.data.size(); i++) {
-    res.data[i] /= rhs;
-  }
+  res /= rhs;
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator+(const U &rhs) const {
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator+(const U &rhs) const {
   Matrix<T, Rows, Cols> res(*this);
-  for (int i = 0; i < res.data.size(); i++) {
-    res.data[i] += rhs;
-  }
+  res += rhs;
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator-(const U &rhs) const {
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::operator-(const U &rhs) const {
   Matrix<T, Rows, Cols> res(*this);
-  for (int i = 0; i < res.data.size(); i++) {
-    res.data[i] -= rhs;
-  }
+  res -= rhs;
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-T Matrix<T, Rows, Cols>::dot(const Matrix<T, Rows, Cols> &rhs) const {
-  if (Cols != 1) {
-    throw std::logic_error("only vectors support dot product.");
-  }
+constexpr T Matrix<T, Rows, Cols>::dot(const Matrix<T, Rows, Cols> &rhs) const {
+  static_assert(Cols == 1, "only vectors support dot product.");
   T res(0);
-  for (int i = 0; i < this->data.size(); i++) {
-    res += (*this)(i) * rhs(i);
+  for (unsigned long i = 0; i < this->size(); i++) {
+    res += data[i] * rhs.data[i];
   }
   return res;
 }
@@ -363,9 +412,9 @@ T Matrix<T, Rows, Cols>::dot(const Matrix<T, Rows, Cols> &rhs) const {
 template<typename T, unsigned long Rows, unsigned long Cols>
 double Matrix<T, Rows, Cols>::norm() const {
   double res = 0.;
-  for (int i = 0; i < width; i++) {
+  for (int i = 0; i < this->cols(); i++) {
     double columnNorm = 0.;
-    for (int j = 0; j < height; j++) {
+    for (int j = 0; j < this->rows(); j++) {
       columnNorm += (*this)(j, i) * (*this)(j, i);
     }
     columnNorm = std::sqrt(columnNorm);
@@ -375,130 +424,126 @@ double Matrix<T, Rows, Cols>::norm() const {
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::cross(const Matrix &rhs) const {
-  if (Rows != 3 || Cols != 1) {
-    throw std::logic_error("only 3d vectors support cross product.");
-  }
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::cross(const Matrix &rhs) const {
+  static_assert(Rows == 3 && Cols == 1, "only 3d vectors support cross product.");
   Matrix<T, Rows, Cols> res;
-  res(0) = (*this)(1) * rhs(2) - (*this)(2) * rhs(1);
-  res(1) = (*this)(2) * rhs(0) - (*this)(0) * rhs(2);
-  res(2) = (*this)(0) * rhs(1) - (*this)(1) * rhs(0);
+  res.data[0] = data[1] * rhs.data[2] - data[2] * rhs.data[1];
+  res.data[1] = data[2] * rhs.data[0] - data[0] * rhs.data[2];
+  res.data[2] = data[0] * rhs.data[1] - data[1] * rhs.data[0];
   return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-T &Matrix<T, Rows, Cols>::operator()(int i) {
-  if (Cols != 1) {
-    throw std::logic_error("use both row and col for matrix indexing.");
-  }
-  return (*this)(i, 0);
+Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::normalize() {
+  *this = static_cast<const Matrix<T, Rows, Cols> *>(this)->normalize();
+  return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-const T &Matrix<T, Rows, Cols>::operator()(int i) const {
-  if (Cols != 1) {
-    throw std::logic_error("use both row and col for matrix indexing.");
+template<typename U>
+constexpr Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator/=(const U &rhs) {
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] /= rhs;
   }
-  return (*this)(i, 0);
-}
-
-template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::normalize() {
-  *this = static_cast<const Matrix<T, Rows, Cols> *>(this)->normalize();
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator/=(const U &rhs) {
-  *this = *this / rhs;
+constexpr Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator*=(const U &rhs) {
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] *= rhs;
+  }
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator*=(const U &rhs) {
-  *this = *this * rhs;
+constexpr Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator+=(const U &rhs) {
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] += rhs;
+  }
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 template<typename U>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator+=(const U &rhs) {
-  *this = *this + rhs;
+constexpr Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator-=(const U &rhs) {
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] -= rhs;
+  }
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-template<typename U>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator-=(const U &rhs) {
-  *this = *this - rhs;
+constexpr Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator+=(const Matrix<T, Rows, Cols> &rhs) {
+  checkSize(rhs);
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] += rhs.data[i];
+  }
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator+=(const Matrix<T, Rows, Cols> &rhs) {
-  *this = *this + rhs;
+constexpr Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator-=(const Matrix<T, Rows, Cols> &rhs) {
+  checkSize(rhs);
+  for (unsigned long i = 0; i < this->size(); i++) {
+    data[i] -= rhs.data[i];
+  }
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::operator-=(const Matrix<T, Rows, Cols> &rhs) {
-  *this = *this - rhs;
+Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::resize(unsigned long rows, unsigned long cols) {
+  this->resizeStorage(rows, cols, T());
   return *this;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols>::Matrix(std::initializer_list<T> initializer) : width(Cols), height(Rows) {
-  if (initializer.size() != Rows * Cols) {
-    throw std::logic_error("wrong initializer list size.");
-  }
-  data = std::vector<T>(initializer);
+T *Matrix<T, Rows, Cols>::getRawData() {
+  return &data[0];
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::resize(unsigned long rows, unsigned long cols) {
-  if (Rows || Cols) {
-    throw std::logic_error("fixed sized matrices cannot be resized.");
-  }
-  height = rows;
-  width = cols;
-  data.resize(height * width);
-  return *this;
+const T *Matrix<T, Rows, Cols>::getRawData() const {
+  return &data[0];
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-T *Matrix<T, Rows, Cols>::getRawData() {
-  return data.data();
+template<typename U>
+Matrix<U, Rows, Cols> Matrix<T, Rows, Cols>::cast() const {
+  Matrix<U, Rows, Cols> res;
+  if (Rows == 0 || Cols == 0) {
+    res.resize(this->rows(), this->cols());
+  }
+  for (unsigned long i = 0; i < this->size(); i++) {
+    res.getRawData()[i] = static_cast<U>(data[i]);
+  }
+  return res;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
 const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::normalize() const {
-  if (this->norm() == 1.) {
+  double norm = this->norm();
+  if (norm == 1.) {
     return *this;
   }
-  return *this / this->norm();
+  return *this / norm;
 }
 
 template<typename T, unsigned long Rows, unsigned long Cols>
-const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::cwiseProduct(const Matrix<T, Rows, Cols> &rhs) const {
-  if (width != rhs.cols() || height != rhs.rows()) {
-    throw std::logic_error("wrong matrix sizes.");
-  }
-  auto res = *this;
-  for (int i = 0; i < res.data.size(); i++) {
+constexpr const Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::cwiseProduct(const Matrix<T, Rows, Cols> &rhs) const {
+  checkSize(rhs);
+  Matrix<T, Rows, Cols> res(*this);
+  for (unsigned long i = 0; i < res.size(); i++) {
     res.data[i] *= rhs.data[i];
   }
   return res;
 }
+
 template<typename T, unsigned long Rows, unsigned long Cols>
 Matrix<T, Rows, Cols> &Matrix<T, Rows, Cols>::resize(unsigned long rows, unsigned long cols, T val) {
-  if (Rows || Cols) {
-    throw std::logic_error("fixed sized matrices cannot be resized.");
-  }
-  height = rows;
-  width = cols;
-  data.resize(height * width, val);
+  this->resizeStorage(rows, cols, val);
   return *this;
 }
 
@@ -511,4 +556,43 @@ using Vector4d = Matrix<double, 4, 1>;
 using Vector3f = Matrix<float, 3, 1>;
 using Vector3uch = Matrix<unsigned char, 3, 1>;
 using Vector3i = Matrix<int, 3, 1>;
+
+/// Scalar type of the geometry pipeline of the renderer: the vertex buffers of the meshes, the transformed vertices,
+/// the edge functions, barycentric coordinates and depths. Single precision with the RASTERIZER_FLOAT_GEOMETRY build
+/// option, double precision otherwise. Loading, caching, subdividing and simplifying meshes stay in double precision.
+#ifdef RASTERIZER_FLOAT_GEOMETRY
+using Real = float;
+#else
+using Real = double;
+#endif
+using Matrix3r = Matrix<Real, 3, 3>;
+using Matrix4r = Matrix<Real, 4, 4>;
+using Vector3r = Matrix<Real, 3, 1>;
+using Vector4r = Matrix<Real, 4, 1>;
+
+/// take over a buffer of matrices of the requested scalar type
+template<typename U, unsigned long Rows, unsigned long Cols>
+std::vector<Matrix<U, Rows, Cols>> castBuffer(std::vector<Matrix<U, Rows, Cols>> &&buffer, std::true_type) {
+  return std::move(buffer);
+}
+
+/// convert a buffer of matrices to another scalar type
+template<typename U, typename T, unsigned long Rows, unsigned long Cols>
+std::vector<Matrix<U, Rows, Cols>> castBuffer(std::vector<Matrix<T, Rows, Cols>> &&buffer, std::false_type) {
+  std::vector<Matrix<U, Rows, Cols>> res;
+  res.reserve(buffer.size());
+  for (const auto &element: buffer) {
+    res.push_back(element.template cast<U>());
+  }
+  return res;
+}
+
+/// convert a buffer of matrices to another scalar type, taking the buffer over if it already has the type
+/// \tparam U scalar data type of the result
+/// \param buffer
+/// \return
+template<typename U, typename T, unsigned long Rows, unsigned long Cols>
+std::vector<Matrix<U, Rows, Cols>> castBuffer(std::vector<Matrix<T, Rows, Cols>> &&buffer) {
+  return castBuffer<U>(std::move(buffer), std::is_same<U, T>());
+}
 #endif //PROG03_INLINEBOOL_MATRIX_H
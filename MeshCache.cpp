@@ -0,0 +1,249 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MESH_CACHE_POSIX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char kMagic[8] = {'P', '0', '5', 'M', 'E', 'S', 'H', '\0'};
+/// bump whenever the layout below or the simplification of the levels of detail changes
+const uint32_t kVersion = 3;
+/// reads back differently on a machine with another byte order
+const uint32_t kByteOrderMarker = 0x01020304u;
+const uint64_t kAlignment = 64;
+
+static_assert(sizeof(Vector3d) == 3 * sizeof(double), "Vector3d must be stored as three packed doubles");
+static_assert(sizeof(Vector3i) == 3 * sizeof(int), "Vector3i must be stored as three packed ints");
+static_assert(sizeof(int) == sizeof(int32_t), "vertex indices are stored as 32 bit integers");
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrderMarker;
+  uint64_t sourceSize;
+  int64_t sourceModifiedTime;
+  uint64_t sourceHash;
+  uint64_t vertexNumber;
+  uint64_t faceNumber;
+  uint64_t boundaryEdgeNumber;
+  uint64_t nonManifoldEdgeNumber;
+  uint64_t positionOffset;
+  uint64_t normalOffset;
+  uint64_t faceOffset;
+  uint64_t oppositeOffset;
+  uint64_t fileSize;
+};
+
+/// identity of the content of a source file
+struct SourceStamp {
+  uint64_t size;
+  /// modification time in nanoseconds, 0 if unknown
+  int64_t modifiedTime;
+};
+
+bool getSourceStamp(const std::string &fileName, SourceStamp &stamp) {
+#ifdef MESH_CACHE_POSIX
+  struct stat status{};
+  if (stat(fileName.c_str(), &status) != 0) {
+    return false;
+  }
+  stamp.size = static_cast<uint64_t>(status.st_size);
+#ifdef __APPLE__
+  const struct timespec &time = status.st_mtimespec;
+#else
+  const struct timespec &time = status.st_mtim;
+#endif
+  stamp.modifiedTime = static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+  return true;
+#else
+  MappedFile file(fileName);
+  stamp.size = file.getSize();
+  stamp.modifiedTime = 0;
+  return file.isOpen();
+#endif
+}
+
+/// 64 bit FNV-1a hash of a whole file
+bool hashFile(const std::string &fileName, uint64_t &hash) {
+  MappedFile file(fileName);
+  if (!file.isOpen()) {
+    return false;
+  }
+  hash = 14695981039346656037ull;
+  const auto *p = reinterpret_cast<const unsigned char *>(file.getData());
+  for (unsigned long i = 0; i < file.getSize(); i++) {
+    hash = (hash ^ p[i]) * 1099511628211ull;
+  }
+  return true;
+}
+
+uint64_t align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+bool isInside(const CacheHeader &header, uint64_t offset, uint64_t bytes) {
+  return offset % kAlignment == 0 && offset <= header.fileSize && bytes <= header.fileSize - offset;
+}
+
+template<class T>
+void copyArray(const char *data, uint64_t offset, uint64_t number, std::vector<T> &array) {
+  array.resize(number);
+  if (number > 0) {
+    std::memcpy(array.data(), data + offset, number * sizeof(T));
+  }
+}
+}
+
+bool MeshCache::enabled = true;
+
+bool MeshCache::read(const std::string &meshFileName, MeshData &data, HalfEdgeAdjacency &adjacency,
+                     unsigned int level) {
+  if (!enabled) {
+    return false;
+  }
+  SourceStamp stamp{};
+  if (!getSourceStamp(meshFileName, stamp)) {
+    return false;
+  }
+  MappedFile file(getCacheFileName(meshFileName, level));
+  if (!file.isOpen() || file.getSize() < sizeof(CacheHeader)) {
+    return false;
+  }
+  CacheHeader header{};
+  std::memcpy(&header, file.getData(), sizeof(CacheHeader));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+      || header.byteOrderMarker != kByteOrderMarker || header.fileSize != file.getSize()
+      || header.sourceSize != stamp.size) {
+    return false;
+  }
+  uint64_t vertexBytes = header.vertexNumber * sizeof(Vector3d);
+  if (header.vertexNumber > file.getSize() || header.faceNumber > file.getSize()
+      || !isInside(header, header.positionOffset, vertexBytes)
+      || !isInside(header, header.normalOffset, vertexBytes)
+      || !isInside(header, header.faceOffset, header.faceNumber * sizeof(Vector3i))
+      || !isInside(header, header.oppositeOffset, header.faceNumber * 3 * sizeof(int32_t))) {
+    return false;
+  }
+  // an unchanged time means an unchanged file, otherwise the file may only have been touched or copied
+  if (stamp.modifiedTime == 0 || header.sourceModifiedTime != stamp.modifiedTime) {
+    uint64_t hash;
+    if (!hashFile(meshFileName, hash) || hash != header.sourceHash) {
+      return false;
+    }
+  }
+  // a corrupt payload would index out of the buffers in the topology and subdivision code, so it is a cache miss
+  if (header.vertexNumber > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())
+      || header.faceNumber * 3 > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+    return false;
+  }
+  MeshData cached;
+  HalfEdgeAdjacency cachedAdjacency;
+  copyArray(file.getData(), header.positionOffset, header.vertexNumber, cached.positions);
+  copyArray(file.getData(), header.normalOffset, header.vertexNumber, cached.normals);
+  copyArray(file.getData(), header.faceOffset, header.faceNumber, cached.faces);
+  copyArray(file.getData(), header.oppositeOffset, header.faceNumber * 3, cachedAdjacency.opposites);
+  auto vertexNumber = static_cast<int32_t>(header.vertexNumber);
+  auto halfEdgeNumber = static_cast<int32_t>(header.faceNumber * 3);
+  for (const auto &face: cached.faces) {
+    for (int k = 0; k < 3; k++) {
+      if (face(k) < 0 || face(k) >= vertexNumber) {
+        return false;
+      }
+    }
+  }
+  for (auto opposite: cachedAdjacency.opposites) {
+    if (opposite < -1 || opposite >= halfEdgeNumber) {
+      return false;
+    }
+  }
+  data = std::move(cached);
+  adjacency = std::move(cachedAdjacency);
+  adjacency.boundaryEdgeNumber = header.boundaryEdgeNumber;
+  adjacency.nonManifoldEdgeNumber = header.nonManifoldEdgeNumber;
+  return true;
+}
+
+bool MeshCache::write(const std::string &meshFileName, const MeshData &data, const HalfEdgeAdjacency &adjacency,
+                      unsigned int level) {
+  if (!enabled || data.normals.size() != data.positions.size()
+      || adjacency.opposites.size() != data.faces.size() * 3) {
+    return false;
+  }
+  CacheHeader header{};
+  SourceStamp stamp{};
+  if (!getSourceStamp(meshFileName, stamp) || !hashFile(meshFileName, header.sourceHash)) {
+    return false;
+  }
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrderMarker = kByteOrderMarker;
+  header.sourceSize = stamp.size;
+  header.sourceModifiedTime = stamp.modifiedTime;
+  header.vertexNumber = data.positions.size();
+  header.faceNumber = data.faces.size();
+  header.boundaryEdgeNumber = adjacency.boundaryEdgeNumber;
+  header.nonManifoldEdgeNumber = adjacency.nonManifoldEdgeNumber;
+  header.positionOffset = align(sizeof(CacheHeader));
+  header.normalOffset = align(header.positionOffset + header.vertexNumber * sizeof(Vector3d));
+  header.faceOffset = align(header.normalOffset + header.vertexNumber * sizeof(Vector3d));
+  header.oppositeOffset = align(header.faceOffset + header.faceNumber * sizeof(Vector3i));
+  header.fileSize = header.oppositeOffset + header.faceNumber * 3 * sizeof(int32_t);
+
+  std::vector<char> buffer(header.fileSize, 0);
+  std::memcpy(buffer.data(), &header, sizeof(CacheHeader));
+  std::memcpy(buffer.data() + header.positionOffset, data.positions.data(), header.vertexNumber * sizeof(Vector3d));
+  std::memcpy(buffer.data() + header.normalOffset, data.normals.data(), header.vertexNumber * sizeof(Vector3d));
+  std::memcpy(buffer.data() + header.faceOffset, data.faces.data(), header.faceNumber * sizeof(Vector3i));
+  std::memcpy(buffer.data() + header.oppositeOffset, adjacency.opposites.data(),
+              header.faceNumber * 3 * sizeof(int32_t));
+
+  // write a temporary file and move it into place, so that concurrent readers never see a partial cache
+  std::string cacheFileName = getCacheFileName(meshFileName, level);
+  std::string temporaryFileName = cacheFileName + ".tmp";
+#ifdef MESH_CACHE_POSIX
+  temporaryFileName += std::to_string(getpid());
+#endif
+  FILE *file = std::fopen(temporaryFileName.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool good = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+  good = std::fclose(file) == 0 && good;
+  if (good) {
+#ifndef MESH_CACHE_POSIX
+    std::remove(cacheFileName.c_str());
+#endif
+    good = std::rename(temporaryFileName.c_str(), cacheFileName.c_str()) == 0;
+  }
+  if (!good) {
+    std::remove(temporaryFileName.c_str());
+  }
+  return good;
+}
+
+std::string MeshCache::getCacheFileName(const std::string &meshFileName, unsigned int level) {
+  // the caches of a single precision build hold its rounded positions and computed normals
+  std::string suffix = sizeof(Real) == sizeof(float) ? ".f32.meshcache" : ".meshcache";
+  if (level > 0) {
+    return meshFileName + ".lod" + std::to_string(level) + suffix;
+  }
+  return meshFileName + suffix;
+}
+
+void MeshCache::setEnabled(bool enabled) {
+  MeshCache::enabled = enabled;
+}
+
+bool MeshCache::isEnabled() {
+  return enabled;
+}
@@ -0,0 +1,55 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_MESHCACHE_H
+#define PROG05_MESHCACHE_H
+
+#include <string>
+#include "MeshIO.h"
+#include "MeshTopology.h"
+
+/// Binary sidecar cache of a parsed mesh file, stored next to it as <mesh file>.meshcache.
+///
+/// The cache holds a fixed header followed by the vertex positions, vertex normals, triangle indices and half edge
+/// opposites, each as a 64 byte aligned array in the in-memory layout of Vector3d, Vector3i and int32_t, so loading
+/// is a bulk copy out of the mapped file. The header records the size, modification time and FNV-1a hash of the
+/// source file; the cache is used when size and time match, or when only the time differs but the hash still does.
+/// Levels of detail simplified from the mesh are cached the same way, one file per level. A level without faces
+/// marks that the simplification stopped at the level before it.
+class MeshCache {
+ public:
+  /// load the cache of a mesh file
+  /// \param meshFileName the source mesh file
+  /// \param data resulted geometry, normals are always filled
+  /// \param adjacency resulted pairing of the half edges
+  /// \param level 0 for the mesh of the file, otherwise the level of detail
+  /// \return false if there is no valid cache for the current content of the mesh file, or if its vertex indices or
+  /// half edge opposites are out of range
+  static bool read(const std::string &meshFileName, MeshData &data, HalfEdgeAdjacency &adjacency,
+                   unsigned int level = 0);
+  /// write the cache of a mesh file. Failures are ignored by the callers, the cache is only an accelerator.
+  /// \param meshFileName the source mesh file
+  /// \param data geometry including the vertex normals
+  /// \param adjacency
+  /// \param level 0 for the mesh of the file, otherwise the level of detail
+  /// \return false if the cache cannot be written
+  static bool write(const std::string &meshFileName, const MeshData &data, const HalfEdgeAdjacency &adjacency,
+                    unsigned int level = 0);
+  /// get the file name of the cache of a mesh file
+  /// \param meshFileName
+  /// \param level 0 for the mesh of the file, <mesh file>.lod<level>.meshcache for a level of detail; the caches of a
+  /// single precision build end with .f32.meshcache instead
+  /// \return
+  static std::string getCacheFileName(const std::string &meshFileName, unsigned int level = 0);
+  /// enable or disable reading and writing caches, enabled by default
+  /// \param enabled
+  static void setEnabled(bool enabled);
+  /// whether caches are read and written
+  /// \return
+  static bool isEnabled();
+ private:
+  static bool enabled;
+};
+
+#endif //PROG05_MESHCACHE_H
@@ -0,0 +1,351 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "MeshIO.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace {
+/// files smaller than this are parsed by a single thread
+const unsigned long kParallelChunkSize = 1ul << 20;
+/// marks a face vertex without a normal
+const int kNoIndex = std::numeric_limits<int>::min();
+
+/// Parsed records of one chunk of an .obj file. Negative indices refer to records before the chunk, so they are
+/// stored relative to the start of the chunk and resolved once the chunks are merged.
+struct ObjChunk {
+  std::vector<Vector3d> positions;
+  std::vector<Vector3d> normals;
+  /// vertex and normal index of every triangle corner
+  std::vector<int> cornerVertices;
+  std::vector<int> cornerNormals;
+  std::vector<unsigned long> relativeVertices;
+  std::vector<unsigned long> relativeNormals;
+  /// start of the first malformed record, where parsing stopped, nullptr if there is none
+  const char *error = nullptr;
+};
+
+inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline void skipSpaces(const char *&p, const char *end) {
+  while (p < end && isSpace(*p)) {
+    p++;
+  }
+}
+
+/// whether only spaces or a comment are left on the line
+inline bool isLineEnd(const char *p, const char *end) {
+  skipSpaces(p, end);
+  return p >= end || *p == '\n' || *p == '#';
+}
+
+inline void skipLine(const char *&p, const char *end) {
+  while (p < end && *p != '\n') {
+    p++;
+  }
+  if (p < end) {
+    p++;
+  }
+}
+
+bool parseInt(const char *&p, const char *end, int &value) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  if (p >= end || !isDigit(*p)) {
+    return false;
+  }
+  long result = 0;
+  while (p < end && isDigit(*p)) {
+    result = result * 10 + (*p - '0');
+    p++;
+  }
+  value = static_cast<int>(negative ? -result : result);
+  return true;
+}
+
+/// parse a decimal floating point number. Numbers whose digits fit in 53 bits and whose exponent is small are
+/// converted exactly with one multiplication or division; everything else falls back to strtod.
+bool parseDouble(const char *&p, const char *end, double &value) {
+  static const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+                                      1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0, exponent = 0;
+  bool anyDigit = false;
+  for (; p < end && isDigit(*p); p++, anyDigit = true) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits += mantissa != 0;
+    } else {
+      exponent++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && isDigit(*p); p++, anyDigit = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa != 0;
+        exponent--;
+      }
+    }
+  }
+  if (!anyDigit) {
+    p = start;
+    return false;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *exponentStart = p++;
+    int exponentValue;
+    if (parseInt(p, end, exponentValue)) {
+      exponent += exponentValue;
+    } else {
+      p = exponentStart;
+    }
+  }
+  if (mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22) {
+    value = exponent < 0 ? mantissa / powersOf10[-exponent] : mantissa * powersOf10[exponent];
+    value = negative ? -value : value;
+    return true;
+  }
+  std::string token(start, p);
+  value = std::strtod(token.c_str(), nullptr);
+  return true;
+}
+
+bool parseVector(const char *&p, const char *end, Vector3d &vector) {
+  for (int k = 0; k < 3; k++) {
+    skipSpaces(p, end);
+    if (!parseDouble(p, end, vector(k))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// parse one face corner in the v, v/vt, v//vn or v/vt/vn syntax
+bool parseCorner(const char *&p, const char *end, int &vertex, int &normal) {
+  if (!parseInt(p, end, vertex)) {
+    return false;
+  }
+  normal = kNoIndex;
+  if (p < end && *p == '/') {
+    p++;
+    int texture;
+    parseInt(p, end, texture);
+    if (p < end && *p == '/') {
+      p++;
+      if (!parseInt(p, end, normal)) {
+        normal = kNoIndex;
+      }
+    }
+  }
+  return true;
+}
+
+/// store a one based or negative index of the file as a zero based index
+void addIndex(int index, int count, std::vector<int> &indices, std::vector<unsigned long> &relative) {
+  if (index < 0) {
+    relative.push_back(indices.size());
+    indices.push_back(count + index);
+  } else {
+    indices.push_back(index - 1);
+  }
+}
+
+void parseChunk(const char *p, const char *end, ObjChunk &chunk) {
+  std::vector<int> polygonVertices, polygonNormals;
+  while (p < end) {
+    skipSpaces(p, end);
+    // a skipped record would shift the indices of all later ones, so parsing stops at the first malformed record
+    const char *record = p;
+    if (p + 1 < end && p[0] == 'v' && isSpace(p[1])) {
+      p++;
+      Vector3d position;
+      if (!parseVector(p, end, position)) {
+        chunk.error = record;
+        return;
+      }
+      chunk.positions.push_back(position);
+    } else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+      p += 2;
+      Vector3d normal;
+      if (!parseVector(p, end, normal)) {
+        chunk.error = record;
+        return;
+      }
+      chunk.normals.push_back(normal);
+    } else if (p + 1 < end && p[0] == 'f' && isSpace(p[1])) {
+      p++;
+      polygonVertices.clear();
+      polygonNormals.clear();
+      int vertex, normal;
+      skipSpaces(p, end);
+      while (parseCorner(p, end, vertex, normal)) {
+        polygonVertices.push_back(vertex);
+        polygonNormals.push_back(normal);
+        skipSpaces(p, end);
+      }
+      if (polygonVertices.size() < 3 || !isLineEnd(p, end)) {
+        chunk.error = record;
+        return;
+      }
+      auto vertexCount = static_cast<int>(chunk.positions.size());
+      auto normalCount = static_cast<int>(chunk.normals.size());
+      for (unsigned long k = 2; k < polygonVertices.size(); k++) {
+        for (unsigned long corner: {0ul, k - 1, k}) {
+          addIndex(polygonVertices[corner], vertexCount, chunk.cornerVertices, chunk.relativeVertices);
+          if (polygonNormals[corner] == kNoIndex) {
+            chunk.cornerNormals.push_back(kNoIndex);
+          } else {
+            addIndex(polygonNormals[corner], normalCount, chunk.cornerNormals, chunk.relativeNormals);
+          }
+        }
+      }
+    }
+    skipLine(p, end);
+  }
+}
+}
+
+bool MeshIO::readObjFile(const std::string &fileName, MeshData &data, std::string &error,
+                         unsigned int threadNumber) {
+  MappedFile file(fileName);
+  if (!file.isOpen()) {
+    error = fileName + ": cannot open the mesh file";
+    return false;
+  }
+  const char *begin = file.getData();
+  const char *end = begin + file.getSize();
+  // split the file at line boundaries
+  std::vector<const char *> boundaries = {begin};
+  auto chunkNumber = std::max(1ul, file.getSize() / kParallelChunkSize);
+  for (unsigned long c = 1; c < chunkNumber; c++) {
+    const char *p = std::max(begin + file.getSize() / chunkNumber * c, boundaries.back());
+    skipLine(p, end);
+    boundaries.push_back(p);
+  }
+  boundaries.push_back(end);
+  std::vector<ObjChunk> chunks(chunkNumber);
+  if (chunkNumber == 1) {
+    parseChunk(begin, end, chunks[0]);
+  } else {
+    ThreadPool threadPool(threadNumber);
+    threadPool.parallelFor(chunkNumber, [&](unsigned long c) {
+      parseChunk(boundaries[c], boundaries[c + 1], chunks[c]);
+    });
+  }
+  for (const auto &chunk: chunks) {
+    if (chunk.error != nullptr) {
+      auto line = std::count(begin, chunk.error, '\n') + 1;
+      std::string record = chunk.error[0] == 'v' && chunk.error[1] == 'n' ? "vn" : std::string(1, chunk.error[0]);
+      error = fileName + ":" + std::to_string(line) + ": malformed " + record + " record";
+      return false;
+    }
+  }
+  // merge the chunks and resolve the indices
+  std::vector<Vector3d> normals;
+  std::vector<int> vertexNormals;
+  data.positions.clear();
+  data.faces.clear();
+  for (auto &chunk: chunks) {
+    auto vertexOffset = static_cast<int>(data.positions.size());
+    auto normalOffset = static_cast<int>(normals.size());
+    for (auto corner: chunk.relativeVertices) {
+      chunk.cornerVertices[corner] += vertexOffset;
+    }
+    for (auto corner: chunk.relativeNormals) {
+      chunk.cornerNormals[corner] += normalOffset;
+    }
+    data.positions.insert(data.positions.end(), chunk.positions.begin(), chunk.positions.end());
+    normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+    vertexNormals.resize(data.positions.size(), kNoIndex);
+    for (unsigned long corner = 0; corner + 2 < chunk.cornerVertices.size(); corner += 3) {
+      data.faces.push_back(Vector3i({chunk.cornerVertices[corner],
+                                     chunk.cornerVertices[corner + 1],
+                                     chunk.cornerVertices[corner + 2]}));
+    }
+    for (unsigned long corner = 0; corner < chunk.cornerVertices.size(); corner++) {
+      int vertex = chunk.cornerVertices[corner], normal = chunk.cornerNormals[corner];
+      if (normal != kNoIndex && vertex >= 0 && vertex < static_cast<int>(vertexNormals.size())
+          && vertexNormals[vertex] == kNoIndex) {
+        vertexNormals[vertex] = normal;
+      }
+    }
+  }
+  auto vertexNumber = static_cast<int>(data.positions.size());
+  for (unsigned long f = 0; f < data.faces.size(); f++) {
+    for (int k = 0; k < 3; k++) {
+      if (data.faces[f](k) < 0 || data.faces[f](k) >= vertexNumber) {
+        error = fileName + ": triangle " + std::to_string(f + 1) + " references a missing vertex, the file has "
+            + std::to_string(vertexNumber) + " vertices";
+        return false;
+      }
+    }
+  }
+  // only keep the normals if every vertex is covered
+  data.normals.clear();
+  vertexNormals.resize(data.positions.size(), kNoIndex);
+  for (auto normal: vertexNormals) {
+    if (normal < 0 || normal >= static_cast<int>(normals.size())) {
+      data.normals.clear();
+      break;
+    }
+    data.normals.push_back(normals[normal]);
+  }
+  return true;
+}
+
+bool MeshIO::writeObjFile(const std::string &fileName,
+                          const std::vector<Vector3d> &positions,
+                          const std::vector<Vector3i> &faces) {
+  FILE *file = std::fopen(fileName.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const unsigned long bufferSize = 1ul << 20;
+  // leave room for one more line after the flush threshold
+  std::vector<char> buffer(bufferSize + 256);
+  unsigned long used = 0;
+  bool good = true;
+  auto flush = [&]() {
+    good = good && std::fwrite(buffer.data(), 1, used, file) == used;
+    used = 0;
+  };
+  for (const auto &position: positions) {
+    used += std::snprintf(buffer.data() + used, buffer.size() - used, "v %.10g %.10g %.10g\n",
+                          position(0), position(1), position(2));
+    if (used >= bufferSize) {
+      flush();
+    }
+  }
+  for (const auto &face: faces) {
+    used += std::snprintf(buffer.data() + used, buffer.size() - used, "f %d %d %d\n",
+                          face(0) + 1, face(1) + 1, face(2) + 1);
+    if (used >= bufferSize) {
+      flush();
+    }
+  }
+  flush();
+  return std::fclose(file) == 0 && good;
+}
@@ -0,0 +1,44 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_MESHIO_H
+#define PROG05_MESHIO_H
+
+#include <string>
+#include <vector>
+#include "Matrix.h"
+
+/// Raw geometry of a triangular mesh file
+struct MeshData {
+  std::vector<Vector3d> positions;
+  /// vertex normals from the vn records referenced by the faces. Empty unless every vertex received one.
+  std::vector<Vector3d> normals;
+  /// zero based vertex indices of the triangles
+  std::vector<Vector3i> faces;
+};
+
+/// Reading and writing of mesh files
+class MeshIO {
+ public:
+  /// read an .obj file. Understands v, vn and f records, including the v/vt/vn, v//vn and v/vt face syntaxes,
+  /// negative (relative) indices and polygons, which are split into triangle fans. Other records are ignored.
+  /// Large files are parsed in parallel chunks.
+  /// \param fileName
+  /// \param data resulted geometry
+  /// \param error reason of the failure, with the line of the first malformed v, vn or f record
+  /// \param threadNumber maximum number of parsing threads, 0 uses all hardware threads
+  /// \return false if the file cannot be opened, has a malformed record or a face referencing a missing vertex
+  static bool readObjFile(const std::string &fileName, MeshData &data, std::string &error,
+                          unsigned int threadNumber = 0);
+  /// write an .obj file with v and f records
+  /// \param fileName
+  /// \param positions vertex positions
+  /// \param faces zero based vertex indices of the triangles
+  /// \return false if the file cannot be written
+  static bool writeObjFile(const std::string &fileName,
+                           const std::vector<Vector3d> &positions,
+                           const std::vector<Vector3i> &faces);
+};
+
+#endif //PROG05_MESHIO_H
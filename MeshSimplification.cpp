@@ -0,0 +1,350 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "MeshSimplification.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+
+namespace {
+/// weight of the planes keeping boundary edges in place, relative to the face planes
+const double kBoundaryWeight = 100.;
+/// smallest cosine between the normals of a face before and after a collapse
+const double kMinNormalCosine = 0.2;
+/// error of the collapses done in a pass, relative to the error of the last collapse needed to reach the target
+const double kCostSlack = 1.5;
+
+/// symmetric 4 x 4 matrix of a quadric error, storing the upper triangle row by row
+struct Quadric {
+  double q[10] = {};
+  /// add the squared distance to the plane n . x + d = 0, scaled by a weight
+  void addPlane(const Vector3d &n, double d, double weight) {
+    double p[4] = {n(0), n(1), n(2), d};
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+      for (int j = i; j < 4; j++) {
+        q[k++] += weight * p[i] * p[j];
+      }
+    }
+  }
+  Quadric &operator+=(const Quadric &rhs) {
+    for (int k = 0; k < 10; k++) {
+      q[k] += rhs.q[k];
+    }
+    return *this;
+  }
+  double evaluate(const Vector3d &x) const {
+    return q[0] * x(0) * x(0) + 2 * q[1] * x(0) * x(1) + 2 * q[2] * x(0) * x(2) + 2 * q[3] * x(0)
+        + q[4] * x(1) * x(1) + 2 * q[5] * x(1) * x(2) + 2 * q[6] * x(1)
+        + q[7] * x(2) * x(2) + 2 * q[8] * x(2) + q[9];
+  }
+  /// find the point of minimal error by solving the 3 x 3 system of the gradient
+  /// \return false if the system is close to singular
+  bool minimize(Vector3d &x) const {
+    double a = q[0], b = q[1], c = q[2], e = q[4], f = q[5], i = q[7];
+    double det = a * (e * i - f * f) - b * (b * i - f * c) + c * (b * f - e * c);
+    double scale = std::abs(a) + std::abs(e) + std::abs(i);
+    if (std::abs(det) <= 1e-12 * scale * scale * scale) {
+      return false;
+    }
+    double r0 = -q[3], r1 = -q[6], r2 = -q[8];
+    // Cramer's rule on the symmetric matrix [a b c; b e f; c f i]
+    x(0) = (r0 * (e * i - f * f) - b * (r1 * i - f * r2) + c * (r1 * f - e * r2)) / det;
+    x(1) = (a * (r1 * i - f * r2) - r0 * (b * i - f * c) + c * (b * r2 - r1 * c)) / det;
+    x(2) = (a * (e * r2 - r1 * f) - b * (b * r2 - r1 * c) + r0 * (b * f - e * c)) / det;
+    return true;
+  }
+};
+
+/// candidate edge collapse moving vertex v into vertex u
+struct Collapse {
+  double cost;
+  int32_t u, v;
+  Vector3d position;
+};
+
+/// Simplification in passes. Every pass computes the error of all edges, sorts them and collapses them in order
+/// of increasing error, skipping the edges next to an edge already collapsed in the pass. Compared to updating a
+/// priority queue after every collapse, every pass only runs linear scans and one sort, which keeps large meshes
+/// in the cache.
+class Simplifier {
+ public:
+  Simplifier(const std::vector<Vector3d> &positions, const std::vector<Vector3i> &faces)
+      : positions(positions), faces(faces), faceRemoved(faces.size(), 0), quadrics(positions.size()),
+        vertexRemoved(positions.size(), 0), boundaryVertices(positions.size(), 0), locked(positions.size(), 0),
+        faceNumber(faces.size()) {}
+
+  void addQuadrics(const HalfEdgeAdjacency &adjacency) {
+    for (unsigned long t = 0; t < faces.size(); t++) {
+      const Vector3d &p0 = positions[faces[t](0)];
+      Vector3d normal = (positions[faces[t](1)] - p0).cross(positions[faces[t](2)] - p0);
+      double area = normal.norm() / 2.;
+      if (area == 0.) {
+        continue;
+      }
+      normal /= 2. * area;
+      Quadric quadric;
+      quadric.addPlane(normal, -normal.dot(p0), area);
+      for (int k = 0; k < 3; k++) {
+        quadrics[faces[t](k)] += quadric;
+      }
+      for (int k = 0; k < 3; k++) {
+        int32_t opposite = adjacency.opposites[t * 3 + k];
+        if (opposite >= 0 && adjacency.opposites[opposite] == static_cast<int32_t>(t * 3 + k)) {
+          continue;
+        }
+        // plane through the boundary edge, perpendicular to the face
+        boundaryVertices[faces[t](k)] = 1;
+        boundaryVertices[faces[t]((k + 1) % 3)] = 1;
+        const Vector3d &a = positions[faces[t](k)];
+        Vector3d edge = positions[faces[t]((k + 1) % 3)] - a;
+        Vector3d side = edge.cross(normal);
+        double length = side.norm();
+        if (length == 0.) {
+          continue;
+        }
+        side /= length;
+        Quadric boundary;
+        boundary.addPlane(side, -side.dot(a), kBoundaryWeight * length * length);
+        quadrics[faces[t](k)] += boundary;
+        quadrics[faces[t]((k + 1) % 3)] += boundary;
+      }
+    }
+  }
+
+  void run(unsigned long targetFaceNumber) {
+    while (faceNumber > targetFaceNumber) {
+      buildVertexFaces();
+      collectCollapses();
+      // a collapse removes two faces, or one on the boundary
+      unsigned long budget = (faceNumber - targetFaceNumber + 1) / 2;
+      unsigned long collapsed = 0;
+      if (collapses.empty()) {
+        break;
+      }
+      // the locked edges push cheap collapses to later passes, which should not be overtaken by expensive ones
+      double costLimit = collapses[std::min(budget, collapses.size() - 1)].cost * kCostSlack;
+      std::fill(locked.begin(), locked.end(), 0);
+      for (const auto &collapse: collapses) {
+        if (collapsed == budget || faceNumber <= targetFaceNumber || collapse.cost > costLimit) {
+          break;
+        }
+        if (locked[collapse.u] || locked[collapse.v] || !isValid(collapse.u, collapse.v, collapse.position)) {
+          continue;
+        }
+        apply(collapse.u, collapse.v, collapse.position);
+        collapsed++;
+      }
+      if (collapsed == 0) {
+        break;
+      }
+    }
+  }
+
+  void getResult(MeshData &result) const {
+    std::vector<int> vertexMap(positions.size(), -1);
+    result.positions.clear();
+    result.normals.clear();
+    result.faces.clear();
+    for (unsigned long t = 0; t < faces.size(); t++) {
+      if (faceRemoved[t]) {
+        continue;
+      }
+      Vector3i face;
+      for (int k = 0; k < 3; k++) {
+        int &vertex = vertexMap[faces[t](k)];
+        if (vertex < 0) {
+          vertex = static_cast<int>(result.positions.size());
+          result.positions.push_back(positions[faces[t](k)]);
+        }
+        face(k) = vertex;
+      }
+      result.faces.push_back(face);
+    }
+  }
+
+ private:
+  /// list the remaining faces around every vertex, in compressed rows
+  void buildVertexFaces() {
+    vertexFaceOffsets.assign(positions.size() + 1, 0);
+    for (unsigned long t = 0; t < faces.size(); t++) {
+      if (!faceRemoved[t]) {
+        for (int k = 0; k < 3; k++) {
+          vertexFaceOffsets[faces[t](k) + 1]++;
+        }
+      }
+    }
+    for (unsigned long v = 0; v < positions.size(); v++) {
+      vertexFaceOffsets[v + 1] += vertexFaceOffsets[v];
+    }
+    vertexFaces.resize(vertexFaceOffsets.back());
+    std::vector<uint32_t> fill(vertexFaceOffsets.begin(), vertexFaceOffsets.end() - 1);
+    for (unsigned long t = 0; t < faces.size(); t++) {
+      if (!faceRemoved[t]) {
+        for (int k = 0; k < 3; k++) {
+          vertexFaces[fill[faces[t](k)]++] = static_cast<int32_t>(t);
+        }
+      }
+    }
+  }
+
+  /// compute the error of every edge and sort the collapses, ties broken by the vertices for a deterministic order
+  void collectCollapses() {
+    collapses.clear();
+    for (unsigned long t = 0; t < faces.size(); t++) {
+      if (faceRemoved[t]) {
+        continue;
+      }
+      for (int k = 0; k < 3; k++) {
+        int32_t u = faces[t](k), v = faces[t]((k + 1) % 3);
+        // inner edges appear in both directions and are taken once, boundary edges may appear in either direction
+        if (u < v || (boundaryVertices[u] && boundaryVertices[v])) {
+          Collapse collapse{0., std::min(u, v), std::max(u, v), Vector3d(0.)};
+          collapse.cost = getCollapsePosition(collapse.u, collapse.v, collapse.position);
+          collapses.push_back(collapse);
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+      if (a.cost != b.cost) {
+        return a.cost < b.cost;
+      }
+      return a.u != b.u ? a.u < b.u : a.v < b.v;
+    });
+  }
+
+  /// find the position minimizing the error of a collapse
+  /// \return the error
+  double getCollapsePosition(int32_t u, int32_t v, Vector3d &position) const {
+    Quadric quadric = quadrics[u];
+    quadric += quadrics[v];
+    if (!quadric.minimize(position)) {
+      // fall back to the best of the end points and the midpoint
+      const Vector3d candidates[3] = {positions[u], positions[v], (positions[u] + positions[v]) / 2.};
+      position = candidates[0];
+      for (const auto &candidate: candidates) {
+        if (quadric.evaluate(candidate) < quadric.evaluate(position)) {
+          position = candidate;
+        }
+      }
+    }
+    return std::max(quadric.evaluate(position), 0.);
+  }
+
+  /// collect the other vertices of the remaining faces around a vertex
+  void getNeighbors(int32_t vertex, std::vector<int32_t> &neighbors) const {
+    neighbors.clear();
+    for (auto i = vertexFaceOffsets[vertex]; i < vertexFaceOffsets[vertex + 1]; i++) {
+      int32_t t = vertexFaces[i];
+      if (faceRemoved[t]) {
+        continue;
+      }
+      for (int k = 0; k < 3; k++) {
+        if (faces[t](k) != vertex) {
+          neighbors.push_back(faces[t](k));
+        }
+      }
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+  }
+
+  bool isValid(int32_t u, int32_t v, const Vector3d &position) {
+    if (vertexRemoved[u] || vertexRemoved[v]) {
+      return false;
+    }
+    // link condition: the common neighbors of u and v must be exactly the opposite vertices of their shared faces
+    getNeighbors(u, uNeighbors);
+    getNeighbors(v, vNeighbors);
+    common.clear();
+    std::set_intersection(uNeighbors.begin(), uNeighbors.end(), vNeighbors.begin(), vNeighbors.end(),
+                          std::back_inserter(common));
+    unsigned long sharedFaces = 0;
+    for (auto i = vertexFaceOffsets[u]; i < vertexFaceOffsets[u + 1]; i++) {
+      const Vector3i &face = faces[vertexFaces[i]];
+      sharedFaces += !faceRemoved[vertexFaces[i]] && (face(0) == v || face(1) == v || face(2) == v);
+    }
+    if (sharedFaces == 0 || common.size() != sharedFaces) {
+      return false;
+    }
+    // an inner edge between two boundary vertices would pinch the surface
+    if (boundaryVertices[u] && boundaryVertices[v] && sharedFaces != 1) {
+      return false;
+    }
+    // no remaining face may flip or degenerate
+    for (int32_t vertex: {u, v}) {
+      for (auto i = vertexFaceOffsets[vertex]; i < vertexFaceOffsets[vertex + 1]; i++) {
+        const Vector3i &face = faces[vertexFaces[i]];
+        if (faceRemoved[vertexFaces[i]]
+            || ((face(0) == u || face(1) == u || face(2) == u) && (face(0) == v || face(1) == v || face(2) == v))) {
+          continue;
+        }
+        Vector3d corners[3];
+        for (int k = 0; k < 3; k++) {
+          corners[k] = face(k) == vertex ? position : positions[face(k)];
+        }
+        const Vector3d &p0 = positions[face(0)];
+        Vector3d before = (positions[face(1)] - p0).cross(positions[face(2)] - p0);
+        Vector3d after = (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+        double beforeNorm = before.norm(), afterNorm = after.norm();
+        if (afterNorm == 0. || before.dot(after) < kMinNormalCosine * beforeNorm * afterNorm) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// move v into u. The face list of u misses the faces of v until the lists are rebuilt, so u stays locked until
+  /// the next pass. The lists of the neighbors only refer to relabeled or removed faces and remain usable.
+  void apply(int32_t u, int32_t v, const Vector3d &position) {
+    positions[u] = position;
+    quadrics[u] += quadrics[v];
+    for (auto i = vertexFaceOffsets[v]; i < vertexFaceOffsets[v + 1]; i++) {
+      int32_t t = vertexFaces[i];
+      Vector3i &face = faces[t];
+      if (faceRemoved[t]) {
+        continue;
+      }
+      if (face(0) == u || face(1) == u || face(2) == u) {
+        faceRemoved[t] = 1;
+        faceNumber--;
+        continue;
+      }
+      for (int k = 0; k < 3; k++) {
+        if (face(k) == v) {
+          face(k) = u;
+        }
+      }
+    }
+    vertexRemoved[v] = 1;
+    locked[u] = 1;
+    boundaryVertices[u] = boundaryVertices[u] || boundaryVertices[v];
+  }
+
+  std::vector<Vector3d> positions;
+  std::vector<Vector3i> faces;
+  std::vector<char> faceRemoved;
+  std::vector<Quadric> quadrics;
+  std::vector<char> vertexRemoved;
+  std::vector<char> boundaryVertices;
+  /// vertices touched by a collapse of the current pass
+  std::vector<char> locked;
+  unsigned long faceNumber;
+  std::vector<uint32_t> vertexFaceOffsets;
+  std::vector<int32_t> vertexFaces;
+  std::vector<Collapse> collapses;
+  std::vector<int32_t> uNeighbors, vNeighbors, common;
+};
+}
+
+void MeshSimplification::simplify(const std::vector<Vector3d> &positions, const std::vector<Vector3i> &faces,
+                                  const HalfEdgeAdjacency &adjacency, unsigned long targetFaceNumber,
+                                  MeshData &result) {
+  Simplifier simplifier(positions, faces);
+  simplifier.addQuadrics(adjacency);
+  simplifier.run(targetFaceNumber);
+  simplifier.getResult(result);
+}
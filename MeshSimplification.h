@@ -0,0 +1,30 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_MESHSIMPLIFICATION_H
+#define PROG05_MESHSIMPLIFICATION_H
+
+#include <vector>
+#include "Matrix.h"
+#include "MeshIO.h"
+#include "MeshTopology.h"
+
+/// Quadric error metric simplification of triangle meshes (Garland and Heckbert).
+///
+/// Every vertex accumulates the area weighted plane quadrics of its faces, plus perpendicular planes along boundary
+/// edges so that borders keep their shape. Edges are collapsed in order of increasing error into the position
+/// minimizing the summed quadric, skipping collapses that would flip a face or make the mesh non-manifold.
+class MeshSimplification {
+ public:
+  /// simplify a mesh
+  /// \param positions vertex positions
+  /// \param faces zero based vertex indices of the triangles
+  /// \param adjacency pairing of the half edges of the faces
+  /// \param targetFaceNumber number of faces to stop at, the result may keep more if no valid collapse is left
+  /// \param result simplified geometry without vertex normals, unused vertices removed
+  static void simplify(const std::vector<Vector3d> &positions, const std::vector<Vector3i> &faces,
+                       const HalfEdgeAdjacency &adjacency, unsigned long targetFaceNumber, MeshData &result);
+};
+
+#endif //PROG05_MESHSIMPLIFICATION_H
@@ -0,0 +1,159 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "MeshTopology.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace {
+/// meshes with fewer half edges are paired by a single thread
+const unsigned long kParallelHalfEdgeNumber = 1ul << 16;
+const unsigned long kChunkSize = 1ul << 14;
+const uint64_t kEmptyKey = ~0ull;
+
+inline uint64_t packEdge(int u, int v) {
+  return static_cast<uint64_t>(static_cast<uint32_t>(u)) << 32 | static_cast<uint32_t>(v);
+}
+
+inline uint64_t reverseEdge(uint64_t key) {
+  return key << 32 | key >> 32;
+}
+
+/// finalizer of MurmurHash3, spreads the vertex indices over all bits
+inline uint64_t hashEdge(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ull;
+  key ^= key >> 33;
+  return key;
+}
+
+/// Open addressing table from directed edges to half edges with linear probing. Insertions from several threads
+/// may run concurrently, lookups must wait until all insertions finished.
+class EdgeTable {
+ public:
+  explicit EdgeTable(unsigned long edgeNumber) : mask(1), slots() {
+    while (mask < edgeNumber * 2) {
+      mask <<= 1;
+    }
+    slots.reset(new Slot[mask]);
+    mask--;
+  }
+
+  void clear(unsigned long begin, unsigned long end) {
+    for (unsigned long i = begin; i < end && i <= mask; i++) {
+      slots[i].key.store(kEmptyKey, std::memory_order_relaxed);
+      slots[i].halfEdge.store(-1, std::memory_order_relaxed);
+      slots[i].shared.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  unsigned long getSlotNumber() const {
+    return mask + 1;
+  }
+
+  /// insert a half edge. A directed edge inserted several times keeps its largest half edge.
+  /// \return whether the directed edge was inserted for the second time
+  bool insert(uint64_t key, int32_t halfEdge) {
+    for (auto i = hashEdge(key) & mask;; i = (i + 1) & mask) {
+      auto &slot = slots[i];
+      uint64_t current = slot.key.load(std::memory_order_relaxed);
+      if (current == kEmptyKey) {
+        slot.key.compare_exchange_strong(current, key, std::memory_order_relaxed);
+      }
+      // current is still empty if this thread claimed the slot
+      if (current == kEmptyKey || current == key) {
+        int32_t stored = slot.halfEdge.load(std::memory_order_relaxed);
+        while (stored < halfEdge
+            && !slot.halfEdge.compare_exchange_weak(stored, halfEdge, std::memory_order_relaxed)) {
+        }
+        return current == key && !slot.shared.exchange(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// \return the half edge of a directed edge, -1 if there is none
+  int32_t find(uint64_t key) const {
+    for (auto i = hashEdge(key) & mask;; i = (i + 1) & mask) {
+      uint64_t current = slots[i].key.load(std::memory_order_relaxed);
+      if (current == key) {
+        return slots[i].halfEdge.load(std::memory_order_relaxed);
+      }
+      if (current == kEmptyKey) {
+        return -1;
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> key;
+    std::atomic<int32_t> halfEdge;
+    std::atomic<bool> shared;
+  };
+  unsigned long mask;
+  std::unique_ptr<Slot[]> slots;
+};
+
+/// run task(begin, end) over consecutive chunks of [0, number), in parallel if a pool is given
+void forEachChunk(ThreadPool *threadPool, unsigned long number,
+                  const std::function<void(unsigned long, unsigned long)> &task) {
+  if (threadPool == nullptr) {
+    task(0, number);
+    return;
+  }
+  threadPool->parallelFor((number + kChunkSize - 1) / kChunkSize, [&](unsigned long c) {
+    task(c * kChunkSize, std::min(number, (c + 1) * kChunkSize));
+  });
+}
+}
+
+void MeshTopology::pairHalfEdges(const std::vector<Vector3i> &faces, HalfEdgeAdjacency &adjacency,
+                                 unsigned int threadNumber) {
+  unsigned long halfEdgeNumber = faces.size() * 3;
+  std::unique_ptr<ThreadPool> threadPool;
+  if (halfEdgeNumber >= kParallelHalfEdgeNumber && threadNumber != 1) {
+    threadPool.reset(new ThreadPool(threadNumber));
+  }
+  auto getKey = [&](unsigned long h) {
+    const Vector3i &face = faces[h / 3];
+    return packEdge(face(static_cast<int>(h % 3)), face(static_cast<int>((h + 1) % 3)));
+  };
+
+  EdgeTable table(halfEdgeNumber);
+  forEachChunk(threadPool.get(), table.getSlotNumber(), [&](unsigned long begin, unsigned long end) {
+    table.clear(begin, end);
+  });
+  std::atomic<uint64_t> nonManifoldEdgeNumber(0), boundaryEdgeNumber(0);
+  forEachChunk(threadPool.get(), halfEdgeNumber, [&](unsigned long begin, unsigned long end) {
+    uint64_t shared = 0;
+    for (unsigned long h = begin; h < end; h++) {
+      shared += table.insert(getKey(h), static_cast<int32_t>(h));
+    }
+    nonManifoldEdgeNumber += shared;
+  });
+  adjacency.opposites.resize(halfEdgeNumber);
+  forEachChunk(threadPool.get(), halfEdgeNumber, [&](unsigned long begin, unsigned long end) {
+    uint64_t boundary = 0;
+    for (unsigned long h = begin; h < end; h++) {
+      adjacency.opposites[h] = table.find(reverseEdge(getKey(h)));
+      boundary += adjacency.opposites[h] < 0;
+    }
+    boundaryEdgeNumber += boundary;
+  });
+  adjacency.boundaryEdgeNumber = boundaryEdgeNumber;
+  adjacency.nonManifoldEdgeNumber = nonManifoldEdgeNumber;
+}
+
+void MeshTopology::findVertexHalfEdges(const std::vector<Vector3i> &faces, unsigned long vertexNumber,
+                                       std::vector<int32_t> &vertexHalfEdges) {
+  vertexHalfEdges.assign(vertexNumber, -1);
+  for (unsigned long h = 0; h < faces.size() * 3; h++) {
+    vertexHalfEdges[getStartVertex(faces, static_cast<int32_t>(h))] = static_cast<int32_t>(h);
+  }
+}
@@ -0,0 +1,157 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_MESHTOPOLOGY_H
+#define PROG05_MESHTOPOLOGY_H
+
+#include <cstdint>
+#include <vector>
+#include "Matrix.h"
+
+/// Pairing of the half edges of a triangle mesh. Half edge t * 3 + i runs from vertex faces[t](i) to vertex
+/// faces[t]((i + 1) % 3).
+struct HalfEdgeAdjacency {
+  /// opposite of every half edge, -1 if there is none
+  std::vector<int32_t> opposites;
+  /// number of half edges without an opposite
+  uint64_t boundaryEdgeNumber = 0;
+  /// number of directed edges used by more than one face, which are non-manifold edges or inconsistently oriented
+  /// faces. All half edges along such an edge share the one with the largest index as their opposite.
+  uint64_t nonManifoldEdgeNumber = 0;
+};
+
+/// Construction of the connectivity of triangle meshes
+class MeshTopology {
+ public:
+  /// pair every half edge with the half edge running in the opposite direction. The directed edges are packed into
+  /// 64 bit keys and inserted into a lock free open addressing table, which is then probed with the reversed keys.
+  /// Large meshes are processed by several threads.
+  /// \param faces zero based vertex indices of the triangles
+  /// \param adjacency resulted pairing
+  /// \param threadNumber maximum number of threads, 0 uses all hardware threads
+  static void pairHalfEdges(const std::vector<Vector3i> &faces, HalfEdgeAdjacency &adjacency,
+                            unsigned int threadNumber = 0);
+  /// find the half edge with the largest index starting at every vertex, -1 for vertices outside of all faces
+  /// \param faces
+  /// \param vertexNumber
+  /// \param vertexHalfEdges resulted half edge of every vertex
+  static void findVertexHalfEdges(const std::vector<Vector3i> &faces, unsigned long vertexNumber,
+                                  std::vector<int32_t> &vertexHalfEdges);
+  /// get the next half edge around the same face
+  /// \param halfEdge
+  /// \return
+  static int32_t getNextHalfEdge(int32_t halfEdge) {
+    return halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1;
+  }
+  /// get the previous half edge around the same face
+  /// \param halfEdge
+  /// \return
+  static int32_t getPreviousHalfEdge(int32_t halfEdge) {
+    return halfEdge % 3 == 0 ? halfEdge + 2 : halfEdge - 1;
+  }
+  /// get the vertex a half edge starts from
+  /// \param faces
+  /// \param halfEdge
+  /// \return
+  static int getStartVertex(const std::vector<Vector3i> &faces, int32_t halfEdge) {
+    return faces[halfEdge / 3](halfEdge % 3);
+  }
+  /// get the vertex a half edge points to
+  /// \param faces
+  /// \param halfEdge
+  /// \return
+  static int getEndVertex(const std::vector<Vector3i> &faces, int32_t halfEdge) {
+    return faces[halfEdge / 3]((halfEdge + 1) % 3);
+  }
+};
+
+/// Half edges leaving a vertex, visited by turning around the vertex from a given half edge. Around a boundary vertex
+/// the turn continues from the given half edge in the other direction once the boundary is met. Usable in range
+/// based for loops without allocating.
+class VertexRing {
+ public:
+  class Iterator {
+   public:
+    Iterator(const std::vector<int32_t> *opposites, int32_t first, int32_t halfEdge)
+        : opposites(opposites), first(first), halfEdge(halfEdge), backward(false), steps(0) {}
+    int32_t operator*() const {
+      return halfEdge;
+    }
+    Iterator &operator++() {
+      // a pairing that is not one to one may never lead back to the first half edge
+      if (++steps > opposites->size()) {
+        halfEdge = -1;
+        return *this;
+      }
+      if (!backward) {
+        int32_t next = (*opposites)[MeshTopology::getPreviousHalfEdge(halfEdge)];
+        if (next >= 0) {
+          halfEdge = next == first ? -1 : next;
+          return *this;
+        }
+        backward = true;
+        halfEdge = first;
+      }
+      int32_t opposite = (*opposites)[halfEdge];
+      halfEdge = opposite < 0 ? -1 : MeshTopology::getNextHalfEdge(opposite);
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const {
+      return halfEdge != other.halfEdge;
+    }
+   private:
+    const std::vector<int32_t> *opposites;
+    int32_t first;
+    int32_t halfEdge;
+    bool backward;
+    unsigned long steps;
+  };
+  /// \param opposites opposite of every half edge
+  /// \param first the half edge to start from, -1 for an empty ring
+  VertexRing(const std::vector<int32_t> &opposites, int32_t first) : opposites(&opposites), first(first) {}
+  Iterator begin() const {
+    return {opposites, first, first};
+  }
+  Iterator end() const {
+    return {opposites, first, -1};
+  }
+ private:
+  const std::vector<int32_t> *opposites;
+  int32_t first;
+};
+
+/// Half edges around a face, starting with the last one of the face. Usable in range based for loops without
+/// allocating.
+class FaceLoop {
+ public:
+  class Iterator {
+   public:
+    Iterator(int32_t face, int corner) : face(face), corner(corner) {}
+    int32_t operator*() const {
+      return face * 3 + (corner + 2) % 3;
+    }
+    Iterator &operator++() {
+      corner++;
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const {
+      return corner != other.corner;
+    }
+   private:
+    int32_t face;
+    int corner;
+  };
+  /// \param face
+  explicit FaceLoop(int32_t face) : face(face) {}
+  Iterator begin() const {
+    return {face, 0};
+  }
+  Iterator end() const {
+    return {face, 3};
+  }
+ private:
+  int32_t face;
+};
+
+#endif //PROG05_MESHTOPOLOGY_H
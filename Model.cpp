@@ -0,0 +1,122 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "Model.h"
+#include "MeshCache.h"
+#include "MeshSimplification.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+
+Model::Model(const std::string &inputFileName, unsigned int threadNumber) {
+  levelsOfDetail.emplace_back(inputFileName, threadNumber);
+  buildLevelsOfDetail(inputFileName, threadNumber);
+}
+
+void Model::buildLevelsOfDetail(const std::string &inputFileName, unsigned int threadNumber) {
+  TRACE_SCOPE("Model::buildLevelsOfDetail");
+  for (unsigned int level = 1;; level++) {
+    const TriMesh &finer = levelsOfDetail.back();
+    unsigned long targetFaceNumber = finer.getFaceIndices().size() / LOD_FACE_RATIO;
+    if (targetFaceNumber < MIN_LOD_FACE_NUMBER) {
+      break;
+    }
+    MeshData data;
+    HalfEdgeAdjacency adjacency;
+    if (MeshCache::read(inputFileName, data, adjacency, level)) {
+      // an empty level marks where the simplification stopped before
+      if (data.faces.empty()) {
+        break;
+      }
+      levelsOfDetail.emplace_back(std::move(data), std::move(adjacency), threadNumber);
+      continue;
+    }
+    MeshSimplification::simplify(castBuffer<double>(std::vector<Vector3r>(finer.getPositionBuffer())),
+                                 finer.getFaceIndices(), finer.getAdjacency(), targetFaceNumber, data);
+    // stop at meshes without enough valid collapses left, such as many disconnected pieces, and remember it so that
+    // later loads do not simplify the mesh again only to stop at the same level
+    if (data.faces.size() * 2 > finer.getFaceIndices().size()) {
+      MeshCache::write(inputFileName, MeshData(), HalfEdgeAdjacency(), level);
+      break;
+    }
+    levelsOfDetail.emplace_back(std::move(data), std::move(adjacency), threadNumber);
+    const TriMesh &coarser = levelsOfDetail.back();
+    MeshData cached{castBuffer<double>(std::vector<Vector3r>(coarser.getPositionBuffer())),
+                    castBuffer<double>(std::vector<Vector3r>(coarser.getNormalBuffer())), coarser.getFaceIndices()};
+    MeshCache::write(inputFileName, cached, coarser.getAdjacency(), level);
+  }
+  // the simplified vertices may move slightly out of the mesh, so the bounds enclose every level
+  for (const auto &mesh: levelsOfDetail) {
+    boundingBox.extend(mesh.getBoundingBox());
+  }
+  if (!boundingBox.isEmpty()) {
+    boundingSphere.center = boundingBox.getCenter();
+    double squaredRadius = 0.;
+    for (const auto &mesh: levelsOfDetail) {
+      for (const auto &position: mesh.getPositionBuffer()) {
+        Vector3d offset = position.cast<double>() - boundingSphere.center;
+        squaredRadius = std::max(squaredRadius, offset.dot(offset));
+      }
+    }
+    boundingSphere.radius = std::sqrt(squaredRadius);
+  }
+}
+
+const TriMesh &Model::getMesh() const {
+  return levelsOfDetail[0];
+}
+
+unsigned int Model::getLevelOfDetailNumber() const {
+  return static_cast<unsigned int>(levelsOfDetail.size());
+}
+
+const TriMesh &Model::getLevelOfDetail(unsigned int level) const {
+  return levelsOfDetail[level];
+}
+
+const AxisAlignedBox &Model::getBoundingBox() const {
+  return boundingBox;
+}
+
+const BoundingSphere &Model::getBoundingSphere() const {
+  return boundingSphere;
+}
+
+ModelLibrary::ModelLibrary(unsigned int threadNumber) : threadNumber(threadNumber) {
+}
+
+std::shared_ptr<const Model> ModelLibrary::getModel(const std::string &inputFileName) {
+  std::promise<std::shared_ptr<const Model>> loading;
+  std::shared_future<std::shared_ptr<const Model>> model;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = models.find(inputFileName);
+    if (found != models.end()) {
+      model = found->second;
+    } else {
+      models[inputFileName] = loading.get_future().share();
+    }
+  }
+  if (model.valid()) {
+    return model.get();
+  }
+  // load outside of the lock, so that other files load at the same time
+  std::shared_ptr<const Model> loaded;
+  try {
+    loaded = std::make_shared<const Model>(inputFileName, threadNumber);
+  } catch (...) {
+    // the waiting requests fail too, and later requests try to load the file again
+    loading.set_exception(std::current_exception());
+    std::lock_guard<std::mutex> lock(mutex);
+    models.erase(inputFileName);
+    throw;
+  }
+  loading.set_value(loaded);
+  return loaded;
+}
+
+unsigned long ModelLibrary::getModelNumber() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return models.size();
+}
@@ -0,0 +1,76 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_MODEL_H
+#define PROG05_MODEL_H
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TriMesh.h"
+#include "BoundingVolume.h"
+
+/// Mesh of a file together with its chain of levels of detail, in model space. A model is loaded once per file and
+/// shared by every surface instancing it.
+class Model {
+ public:
+  /// ratio between the face numbers of consecutive levels of detail
+  static const unsigned long LOD_FACE_RATIO = 4;
+  /// levels of detail are only built while they keep at least this many faces
+  static const unsigned long MIN_LOD_FACE_NUMBER = 256;
+  /// Read a mesh file. The levels of detail are simplified from the mesh, or loaded from the mesh cache.
+  /// \param inputFileName input mesh file name
+  /// \param threadNumber maximum number of threads loading the mesh, 0 uses all hardware threads
+  explicit Model(const std::string &inputFileName, unsigned int threadNumber = 0);
+  /// get the mesh of the file
+  /// \return
+  const TriMesh &getMesh() const;
+  /// get the number of levels of detail, including the mesh itself
+  /// \return
+  unsigned int getLevelOfDetailNumber() const;
+  /// get a level of detail
+  /// \param level 0 for the mesh itself, every further level has about LOD_FACE_RATIO times fewer faces
+  /// \return
+  const TriMesh &getLevelOfDetail(unsigned int level) const;
+  /// get the bounding box in model space, enclosing all levels of detail
+  /// \return
+  const AxisAlignedBox &getBoundingBox() const;
+  /// get a bounding sphere in model space centered at the center of the bounding box, enclosing all levels of detail
+  /// \return
+  const BoundingSphere &getBoundingSphere() const;
+ private:
+  void buildLevelsOfDetail(const std::string &inputFileName, unsigned int threadNumber);
+  /// the mesh itself followed by its simplifications
+  std::vector<TriMesh> levelsOfDetail;
+  AxisAlignedBox boundingBox;
+  BoundingSphere boundingSphere;
+};
+
+/// Models loaded so far, by file name. A library can be shared by scenes loaded one after the other or at the same
+/// time, which then load every file only once.
+class ModelLibrary {
+ public:
+  /// Construct an empty library
+  /// \param threadNumber maximum number of threads loading each model, 0 uses all hardware threads. Models loaded at
+  /// the same time each use this many threads.
+  explicit ModelLibrary(unsigned int threadNumber = 0);
+  /// get the model of a file, loading it on the first request. Concurrent requests for a file being loaded wait for
+  /// it instead of loading it again. If loading fails, the exception reaches every waiting request, and the next
+  /// request loads the file again.
+  /// \param inputFileName
+  /// \return
+  std::shared_ptr<const Model> getModel(const std::string &inputFileName);
+  /// get the number of models loaded
+  /// \return
+  unsigned long getModelNumber();
+ private:
+  unsigned int threadNumber;
+  std::mutex mutex;
+  std::map<std::string, std::shared_future<std::shared_ptr<const Model>>> models;
+};
+
+#endif //PROG05_MODEL_H
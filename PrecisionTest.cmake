@@ -0,0 +1,34 @@
+#
+# Created by Jiang Kairong on 10/17/26.
+#
+# Renders the bundled scenes with the double and single precision command line renderers, and fails if a single
+# precision image has a lower PSNR than allowed for its shading policy. Pixels on the edges between faces may take the
+# color of the neighboring face in flat shading, so flat shading allows a lower PSNR than the interpolated policies.
+#
+# cmake -DDOUBLE_CLI=<cli> -DFLOAT_CLI=<cli> -DSOURCE_DIR=<repository> -DOUTPUT_DIR=<directory> -P PrecisionTest.cmake
+
+set(SCENES kitten.txt myscene.txt ballring.txt 2spheres1.txt pointlights.txt)
+# shading policies rendered together and the lowest PSNR in dB of their images
+set(POLICY_GROUPS flat gouraud,phong)
+set(MIN_PSNR_flat 59.6)
+set(MIN_PSNR_gouraud_phong 81)
+
+foreach (GROUP ${POLICY_GROUPS})
+    string(REPLACE "," "_" GROUP_NAME ${GROUP})
+    set(REFERENCE_DIR ${OUTPUT_DIR}/double_${GROUP_NAME})
+    set(IMAGE_DIR ${OUTPUT_DIR}/float_${GROUP_NAME})
+    file(REMOVE_RECURSE ${REFERENCE_DIR} ${IMAGE_DIR})
+    file(MAKE_DIRECTORY ${REFERENCE_DIR} ${IMAGE_DIR})
+    execute_process(COMMAND ${DOUBLE_CLI} -q -p ${GROUP} -o ${REFERENCE_DIR} ${SCENES}
+            WORKING_DIRECTORY ${SOURCE_DIR} RESULT_VARIABLE RESULT)
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "the double precision renderer failed on the ${GROUP} images")
+    endif ()
+    execute_process(COMMAND ${FLOAT_CLI} -p ${GROUP} -o ${IMAGE_DIR} --compare ${REFERENCE_DIR}
+            --min-psnr ${MIN_PSNR_${GROUP_NAME}} ${SCENES}
+            WORKING_DIRECTORY ${SOURCE_DIR} RESULT_VARIABLE RESULT)
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "the single precision ${GROUP} images differ from double precision by more than "
+                "${MIN_PSNR_${GROUP_NAME}} dB PSNR allows")
+    endif ()
+endforeach ()
@@ -0,0 +1,258 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "RasterKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RASTER_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+/// barycentric coordinates may leave [0, 1] by this much, so that neighboring triangles overlap slightly
+const Real kBaryTolerance = 0.01;
+
+inline bool coversPixel(const EdgeSetup &setup, const Real *rowBase, Real rowDepth, int x, Real depth) {
+  auto dx = static_cast<Real>(x);
+  for (int k = 0; k < 3; k++) {
+    Real baryCoord = setup.a[k] * dx + rowBase[k];
+    if (!(baryCoord >= -kBaryTolerance && baryCoord <= 1 + kBaryTolerance)) {
+      return false;
+    }
+  }
+  return !(depth > setup.az * dx + rowDepth);
+}
+
+int coverSpanScalar(const EdgeSetup &setup, int y, int xBegin, int xEnd, const Real *depthRow, int *covered) {
+  auto dy = static_cast<Real>(y);
+  Real rowBase[3];
+  for (int k = 0; k < 3; k++) {
+    rowBase[k] = setup.b[k] * dy + setup.c[k];
+  }
+  Real rowDepth = setup.bz * dy + setup.cz;
+  int coveredNumber = 0;
+  for (int x = xBegin; x < xEnd; x++) {
+    if (coversPixel(setup, rowBase, rowDepth, x, depthRow[x - xBegin])) {
+      covered[coveredNumber++] = x;
+    }
+  }
+  return coveredNumber;
+}
+
+#ifdef RASTER_KERNEL_X86
+#ifdef RASTERIZER_FLOAT_GEOMETRY
+__attribute__((target("sse2")))
+int coverSpanSse2(const EdgeSetup &setup, int y, int xBegin, int xEnd, const float *depthRow, int *covered) {
+  auto dy = static_cast<float>(y);
+  float rowBase[3];
+  __m128 a[3], base[3];
+  for (int k = 0; k < 3; k++) {
+    rowBase[k] = setup.b[k] * dy + setup.c[k];
+    a[k] = _mm_set1_ps(setup.a[k]);
+    base[k] = _mm_set1_ps(rowBase[k]);
+  }
+  float rowDepth = setup.bz * dy + setup.cz;
+  const __m128 az = _mm_set1_ps(setup.az), baseDepth = _mm_set1_ps(rowDepth);
+  const __m128 lower = _mm_set1_ps(-kBaryTolerance), upper = _mm_set1_ps(1 + kBaryTolerance);
+  const __m128 step = _mm_set1_ps(4.f);
+  auto x0 = static_cast<float>(xBegin);
+  __m128 xs = _mm_setr_ps(x0, x0 + 1.f, x0 + 2.f, x0 + 3.f);
+  int coveredNumber = 0;
+  int x = xBegin;
+  for (; x + 4 <= xEnd; x += 4, xs = _mm_add_ps(xs, step)) {
+    __m128 pass = _mm_cmpngt_ps(_mm_loadu_ps(depthRow + (x - xBegin)), _mm_add_ps(_mm_mul_ps(az, xs), baseDepth));
+    for (int k = 0; k < 3; k++) {
+      __m128 baryCoord = _mm_add_ps(_mm_mul_ps(a[k], xs), base[k]);
+      pass = _mm_and_ps(pass, _mm_and_ps(_mm_cmpge_ps(baryCoord, lower), _mm_cmple_ps(baryCoord, upper)));
+    }
+    for (int mask = _mm_movemask_ps(pass); mask; mask &= mask - 1) {
+      covered[coveredNumber++] = x + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+  }
+  for (; x < xEnd; x++) {
+    if (coversPixel(setup, rowBase, rowDepth, x, depthRow[x - xBegin])) {
+      covered[coveredNumber++] = x;
+    }
+  }
+  return coveredNumber;
+}
+
+__attribute__((target("avx")))
+int coverSpanAvx(const EdgeSetup &setup, int y, int xBegin, int xEnd, const float *depthRow, int *covered) {
+  auto dy = static_cast<float>(y);
+  float rowBase[3];
+  __m256 a[3], base[3];
+  for (int k = 0; k < 3; k++) {
+    rowBase[k] = setup.b[k] * dy + setup.c[k];
+    a[k] = _mm256_set1_ps(setup.a[k]);
+    base[k] = _mm256_set1_ps(rowBase[k]);
+  }
+  float rowDepth = setup.bz * dy + setup.cz;
+  const __m256 az = _mm256_set1_ps(setup.az), baseDepth = _mm256_set1_ps(rowDepth);
+  const __m256 lower = _mm256_set1_ps(-kBaryTolerance), upper = _mm256_set1_ps(1 + kBaryTolerance);
+  const __m256 step = _mm256_set1_ps(8.f);
+  auto x0 = static_cast<float>(xBegin);
+  __m256 xs = _mm256_setr_ps(x0, x0 + 1.f, x0 + 2.f, x0 + 3.f, x0 + 4.f, x0 + 5.f, x0 + 6.f, x0 + 7.f);
+  int coveredNumber = 0;
+  int x = xBegin;
+  for (; x + 8 <= xEnd; x += 8, xs = _mm256_add_ps(xs, step)) {
+    __m256 pass = _mm256_cmp_ps(_mm256_loadu_ps(depthRow + (x - xBegin)),
+                                _mm256_add_ps(_mm256_mul_ps(az, xs), baseDepth), _CMP_NGT_UQ);
+    for (int k = 0; k < 3; k++) {
+      __m256 baryCoord = _mm256_add_ps(_mm256_mul_ps(a[k], xs), base[k]);
+      pass = _mm256_and_ps(pass, _mm256_and_ps(_mm256_cmp_ps(baryCoord, lower, _CMP_GE_OQ),
+                                               _mm256_cmp_ps(baryCoord, upper, _CMP_LE_OQ)));
+    }
+    for (int mask = _mm256_movemask_ps(pass); mask; mask &= mask - 1) {
+      covered[coveredNumber++] = x + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+  }
+  for (; x < xEnd; x++) {
+    if (coversPixel(setup, rowBase, rowDepth, x, depthRow[x - xBegin])) {
+      covered[coveredNumber++] = x;
+    }
+  }
+  return coveredNumber;
+}
+#else
+__attribute__((target("sse2")))
+int coverSpanSse2(const EdgeSetup &setup, int y, int xBegin, int xEnd, const double *depthRow, int *covered) {
+  auto dy = static_cast<double>(y);
+  double rowBase[3];
+  __m128d a[3], base[3];
+  for (int k = 0; k < 3; k++) {
+    rowBase[k] = setup.b[k] * dy + setup.c[k];
+    a[k] = _mm_set1_pd(setup.a[k]);
+    base[k] = _mm_set1_pd(rowBase[k]);
+  }
+  double rowDepth = setup.bz * dy + setup.cz;
+  const __m128d az = _mm_set1_pd(setup.az), baseDepth = _mm_set1_pd(rowDepth);
+  const __m128d lower = _mm_set1_pd(-kBaryTolerance), upper = _mm_set1_pd(1. + kBaryTolerance);
+  const __m128d step = _mm_set1_pd(2.);
+  __m128d xs = _mm_setr_pd(xBegin, xBegin + 1.);
+  int coveredNumber = 0;
+  int x = xBegin;
+  for (; x + 2 <= xEnd; x += 2, xs = _mm_add_pd(xs, step)) {
+    __m128d pass = _mm_cmpngt_pd(_mm_loadu_pd(depthRow + (x - xBegin)), _mm_add_pd(_mm_mul_pd(az, xs), baseDepth));
+    for (int k = 0; k < 3; k++) {
+      __m128d baryCoord = _mm_add_pd(_mm_mul_pd(a[k], xs), base[k]);
+      pass = _mm_and_pd(pass, _mm_and_pd(_mm_cmpge_pd(baryCoord, lower), _mm_cmple_pd(baryCoord, upper)));
+    }
+    for (int mask = _mm_movemask_pd(pass); mask; mask &= mask - 1) {
+      covered[coveredNumber++] = x + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+  }
+  for (; x < xEnd; x++) {
+    if (coversPixel(setup, rowBase, rowDepth, x, depthRow[x - xBegin])) {
+      covered[coveredNumber++] = x;
+    }
+  }
+  return coveredNumber;
+}
+
+__attribute__((target("avx")))
+int coverSpanAvx(const EdgeSetup &setup, int y, int xBegin, int xEnd, const double *depthRow, int *covered) {
+  auto dy = static_cast<double>(y);
+  double rowBase[3];
+  __m256d a[3], base[3];
+  for (int k = 0; k < 3; k++) {
+    rowBase[k] = setup.b[k] * dy + setup.c[k];
+    a[k] = _mm256_set1_pd(setup.a[k]);
+    base[k] = _mm256_set1_pd(rowBase[k]);
+  }
+  double rowDepth = setup.bz * dy + setup.cz;
+  const __m256d az = _mm256_set1_pd(setup.az), baseDepth = _mm256_set1_pd(rowDepth);
+  const __m256d lower = _mm256_set1_pd(-kBaryTolerance), upper = _mm256_set1_pd(1. + kBaryTolerance);
+  const __m256d step = _mm256_set1_pd(4.);
+  __m256d xs = _mm256_setr_pd(xBegin, xBegin + 1., xBegin + 2., xBegin + 3.);
+  int coveredNumber = 0;
+  int x = xBegin;
+  for (; x + 4 <= xEnd; x += 4, xs = _mm256_add_pd(xs, step)) {
+    __m256d pass = _mm256_cmp_pd(_mm256_loadu_pd(depthRow + (x - xBegin)),
+                                 _mm256_add_pd(_mm256_mul_pd(az, xs), baseDepth), _CMP_NGT_UQ);
+    for (int k = 0; k < 3; k++) {
+      __m256d baryCoord = _mm256_add_pd(_mm256_mul_pd(a[k], xs), base[k]);
+      pass = _mm256_and_pd(pass, _mm256_and_pd(_mm256_cmp_pd(baryCoord, lower, _CMP_GE_OQ),
+                                               _mm256_cmp_pd(baryCoord, upper, _CMP_LE_OQ)));
+    }
+    for (int mask = _mm256_movemask_pd(pass); mask; mask &= mask - 1) {
+      covered[coveredNumber++] = x + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+  }
+  for (; x < xEnd; x++) {
+    if (coversPixel(setup, rowBase, rowDepth, x, depthRow[x - xBegin])) {
+      covered[coveredNumber++] = x;
+    }
+  }
+  return coveredNumber;
+}
+#endif
+#endif
+}
+
+bool RasterKernel::setupTriangle(const Vector3r &v0, const Vector3r &v1, const Vector3r &v2, EdgeSetup &setup) {
+  const Vector3d vertices[3] = {v0.cast<double>(), v1.cast<double>(), v2.cast<double>()};
+  double a[3], b[3], c[3];
+  for (int k = 0; k < 3; k++) {
+    // edge k is the line through the two vertices opposite to vertex k
+    const Vector3d &p = vertices[(k + 1) % 3];
+    const Vector3d &q = vertices[(k + 2) % 3];
+    a[k] = p(1) - q(1);
+    b[k] = q(0) - p(0);
+    c[k] = p(0) * q(1) - q(0) * p(1);
+    double d = a[k] * vertices[k](0) + b[k] * vertices[k](1) + c[k];
+    if (d == 0 || !std::isfinite(d)) {
+      return false;
+    }
+    a[k] /= d;
+    b[k] /= d;
+    c[k] /= d;
+  }
+  double az = 0, bz = 0, cz = 0;
+  for (int k = 0; k < 3; k++) {
+    az += vertices[k](2) * a[k];
+    bz += vertices[k](2) * b[k];
+    cz += vertices[k](2) * c[k];
+    setup.a[k] = static_cast<Real>(a[k]);
+    setup.b[k] = static_cast<Real>(b[k]);
+    setup.c[k] = static_cast<Real>(c[k]);
+  }
+  setup.az = static_cast<Real>(az);
+  setup.bz = static_cast<Real>(bz);
+  setup.cz = static_cast<Real>(cz);
+  return true;
+}
+
+RasterKernel::InstructionSet RasterKernel::detectInstructionSet() {
+#ifdef RASTER_KERNEL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx")) {
+    return AVX;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SSE2;
+  }
+#endif
+  return SCALAR;
+}
+
+RasterKernel::SpanFunction RasterKernel::getSpanFunction(InstructionSet instructionSet) {
+  switch (instructionSet) {
+#ifdef RASTER_KERNEL_X86
+    case AVX:return coverSpanAvx;
+    case SSE2:return coverSpanSse2;
+#endif
+    case SCALAR:
+    default:return coverSpanScalar;
+  }
+}
+
+const char *RasterKernel::getInstructionSetName(InstructionSet instructionSet) {
+  switch (instructionSet) {
+    case AVX:return "AVX";
+    case SSE2:return "SSE2";
+    case SCALAR:
+    default:return "scalar";
+  }
+}
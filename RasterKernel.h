@@ -0,0 +1,77 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_RASTERKERNEL_H
+#define PROG05_RASTERKERNEL_H
+
+#include "Matrix.h"
+
+/// Half-space (edge function) setup of a screen space triangle. The barycentric coordinate k of pixel (x, y) is
+/// a[k] * x + (b[k] * y + c[k]), and its depth is az * x + (bz * y + cz). Every kernel evaluates exactly these
+/// expressions, so all instruction sets produce the same image.
+struct EdgeSetup {
+  Real a[3], b[3], c[3];
+  Real az, bz, cz;
+};
+
+/// Edge function rasterization kernels with run time instruction set selection. The vector kernels test 2 or 4
+/// pixels at a time in double precision, and 4 or 8 pixels with the RASTERIZER_FLOAT_GEOMETRY build option.
+class RasterKernel {
+ public:
+  enum InstructionSet {
+    SCALAR,
+    SSE2,
+    AVX
+  };
+  /// Find the pixels of a row span that are inside the triangle and pass the depth test.
+  /// \param setup edge functions of the triangle
+  /// \param y row of the span
+  /// \param xBegin first pixel of the span
+  /// \param xEnd one past the last pixel of the span
+  /// \param depthRow depth buffer values of the span, depthRow[0] belongs to xBegin
+  /// \param covered receives the x coordinates of the passing pixels, needs room for xEnd - xBegin entries
+  /// \return number of passing pixels
+  typedef int (*SpanFunction)(const EdgeSetup &setup, int y, int xBegin, int xEnd, const Real *depthRow,
+                              int *covered);
+  /// compute the edge functions of a triangle. The setup runs in double precision in every build: the constant terms
+  /// cancel products of screen coordinates, which single precision rounds to visible depth errors.
+  /// \param v0 screen space vertices of the triangle
+  /// \param v1 screen space vertices of the triangle
+  /// \param v2 screen space vertices of the triangle
+  /// \param setup resulted edge functions
+  /// \return false if the triangle is degenerate and covers no pixel
+  static bool setupTriangle(const Vector3r &v0, const Vector3r &v1, const Vector3r &v2, EdgeSetup &setup);
+  /// get the barycentric coordinate of a pixel, bit identical to the values tested by the kernels
+  /// \param setup
+  /// \param x
+  /// \param y
+  /// \return
+  static Vector3r getBaryCoord(const EdgeSetup &setup, int x, int y) {
+    auto dx = static_cast<Real>(x), dy = static_cast<Real>(y);
+    return Vector3r({setup.a[0] * dx + (setup.b[0] * dy + setup.c[0]),
+                     setup.a[1] * dx + (setup.b[1] * dy + setup.c[1]),
+                     setup.a[2] * dx + (setup.b[2] * dy + setup.c[2])});
+  }
+  /// get the depth of a pixel, bit identical to the values tested by the kernels
+  /// \param setup
+  /// \param x
+  /// \param y
+  /// \return
+  static Real getDepth(const EdgeSetup &setup, int x, int y) {
+    return setup.az * static_cast<Real>(x) + (setup.bz * static_cast<Real>(y) + setup.cz);
+  }
+  /// get the widest instruction set supported by the running CPU
+  /// \return
+  static InstructionSet detectInstructionSet();
+  /// get the span kernel for an instruction set
+  /// \param instructionSet
+  /// \return
+  static SpanFunction getSpanFunction(InstructionSet instructionSet);
+  /// get a printable name of an instruction set
+  /// \param instructionSet
+  /// \return
+  static const char *getInstructionSetName(InstructionSet instructionSet);
+};
+
+#endif //PROG05_RASTERKERNEL_H
@@ -4,11 +4,108 @@
 
 #include "Renderer.h"
 #include "Utils.h"
+#include "Trace.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+/// depth value of a pixel that no fragment has covered yet
+const Real kEmptyDepth = -std::numeric_limits<Real>::infinity();
+/// values of Renderer::visibleObjects
+enum ObjectVisibility : char {
+  OBJECT_OUTSIDE = 0,
+  OBJECT_VISIBLE = 1,
+  OBJECT_OCCLUDED = 2
+};
+/// added to the nearest depth of a box tested for occlusion, covering the rounding of the rasterized depths
+const double kOcclusionDepthBias = sizeof(Real) == sizeof(float) ? 1e-5 : 1e-9;
+}
+
+std::string RenderStats::toJson() const {
+  std::ostringstream out;
+  out.precision(9);
+  out << "{\"submitted\": " << primitives.submitted << ", \"levelOfDetailReduced\": " << primitives.levelOfDetailReduced
+      << ", \"objectsCulled\": " << primitives.objectsCulled << ", \"frustumCulled\": " << primitives.frustumCulled
+      << ", \"objectsOccluded\": " << primitives.objectsOccluded << ", \"occlusionCulled\": "
+      << primitives.occlusionCulled << ", \"backFaceCulled\": " << primitives.backFaceCulled << ", \"degenerate\": "
+      << primitives.degenerate << ", \"nearClipped\": " << primitives.nearClipped << ", \"rasterized\": "
+      << primitives.rasterized << ", \"verticesTransformed\": " << verticesTransformed << ", \"pixelsTested\": "
+      << pixelsTested << ", \"depthPassed\": " << depthPassed << ", \"fragments\": " << fragments
+      << ", \"fragmentsShaded\": " << fragmentsShaded << ", \"overdraw\": " << overdraw << ", \"lightEvaluations\": "
+      << lightEvaluations;
+  const std::pair<const char *, double> stageTimes[] = {
+      {"prepareBuffers", times.prepareBuffers}, {"prepareMatrices", times.prepareMatrices},
+      {"cullObjects", times.cullObjects}, {"processVertices", times.processVertices}, {"rasterize", times.rasterize},
+      {"fragmentShading", times.fragmentShading}, {"convert", times.convert}};
+  const char *separator = "";
+  out << ", \"seconds\": {";
+  for (const auto &stage: stageTimes) {
+    out << separator << "\"" << stage.first << "\": " << stage.second;
+    separator = ", ";
+  }
+  const std::pair<const char *, unsigned long> stageBytes[] = {
+      {"prepareBuffers", bytes.prepareBuffers}, {"cullObjects", bytes.cullObjects},
+      {"processVertices", bytes.processVertices}, {"rasterize", bytes.rasterize},
+      {"fragmentShading", bytes.fragmentShading}, {"convert", bytes.convert}};
+  separator = "";
+  out << "}, \"bytes\": {";
+  for (const auto &stage: stageBytes) {
+    out << separator << "\"" << stage.first << "\": " << stage.second;
+    separator = ", ";
+  }
+  out << "}}";
+  return out.str();
+}
+void GBuffer::resize(unsigned long pixelNumber, bool attributes) {
+  depth.resize(pixelNumber);
+  visibility.resize(pixelNumber);
+  auto attributeNumber = attributes ? pixelNumber : 0;
+  flatColors.resize(attributeNumber);
+  gouraudColors.resize(attributeNumber);
+  positionX.resize(attributeNumber);
+  positionY.resize(attributeNumber);
+  positionZ.resize(attributeNumber);
+  normalX.resize(attributeNumber);
+  normalY.resize(attributeNumber);
+  normalZ.resize(attributeNumber);
+  materials.resize(attributeNumber);
+}
+void Renderer::prepareBuffers() {
+  auto imageSize = camera.getImageSize();
+  if (imageSize != bufferSize) {
+    tileColumns = (imageSize.first + TILE_SIZE - 1) / TILE_SIZE;
+    int tileRows = (imageSize.second + TILE_SIZE - 1) / TILE_SIZE;
+    tiles.assign(static_cast<unsigned long>(tileColumns * tileRows), Tile());
+    for (int r = 0; r < tileRows; r++) {
+      for (int c = 0; c < tileColumns; c++) {
+        Tile &tile = tiles[r * tileColumns + c];
+        tile.rowBegin = r * TILE_SIZE;
+        tile.rowEnd = std::min(tile.rowBegin + TILE_SIZE, imageSize.second);
+        tile.colBegin = c * TILE_SIZE;
+        tile.colEnd = std::min(tile.colBegin + TILE_SIZE, imageSize.first);
+      }
+    }
+    bufferSize = imageSize;
+  }
+  for (auto &tile: tiles) {
+    auto pixelNumber = static_cast<unsigned long>((tile.rowEnd - tile.rowBegin) * (tile.colEnd - tile.colBegin));
+    tile.gBuffer.resize(pixelNumber, !visibilityBuffer);
+    tile.triangles.clear();
+  }
+  triangles.clear();
+  for (int policy = 0; policy < SHADING_POLICY_NUMBER; policy++) {
+    if (passPolicies & 1u << policy) {
+      frameBuffers[policy]->resize(static_cast<unsigned long>(imageSize.second),
+                                   static_cast<unsigned long>(imageSize.first), ColorRGB32f(0.f));
+    }
+  }
+}
 void Renderer::prepareMatrices() {
-  auto camera = scene->getMainCamera();
   Vector3d lookDirection = camera.getLookAtPosition() - camera.getEyePosition();
   Vector3d u = lookDirection.cross(camera.getUpDirection()).normalize();
   Vector3d v = u.cross(lookDirection).normalize();
@@ -28,120 +125,515 @@ void Renderer::prepareMatrices() {
   int ny = camera.getImageSize().second;
   Matrix4d mVp = Utils::makeViewPortTransformMatrix(nx, ny);
 //  mVp.print(std::cout);
-  m = mVp * mPer * mCam;
+  // negated so that w > 0 in front of the camera, which looks down the negative z axis of its coordinate system.
+  // Negating does not change any bit of the positions after the homogeneous division.
+  m = mVp * mPer * mCam * -1.;
 //  m.print(std::cout);
 }
+void Renderer::cullObjects() {
+  auto imageSize = camera.getImageSize();
+  Vector4d planes[6];
+  Clipper::getFrustumPlanes(m, imageSize.first, imageSize.second, planes);
+  renderStats.primitives = PrimitiveCounters();
+  renderStats.primitives.objectsCulled = scene->getHierarchy().cull(planes, 6, visibleObjects);
+  projectedObjects.assign(visibleObjects.size(), 0);
+  selectLevelsOfDetail();
+  if (occlusionCulling) {
+    cullOccludedObjects();
+  }
+}
+void Renderer::selectLevelsOfDetail() {
+  const auto &objects = scene->getObjects();
+  // pixels per unit length at unit distance from the eye
+  double focalLength = camera.getImageSize().second / (2. * std::tan(camera.getAngle() * M_PI / 360.));
+  objectMeshes.resize(objects.size());
+  for (unsigned int o = 0; o < objects.size(); o++) {
+    const Surface &object = *objects[o];
+    objectMeshes[o] = &object.getMesh();
+    if (!levelOfDetail || visibleObjects[o] != OBJECT_VISIBLE) {
+      continue;
+    }
+    const BoundingSphere &sphere = object.getBoundingSphere();
+    double distance = (sphere.center - camera.getEyePosition()).norm();
+    if (distance <= sphere.radius) {
+      continue;
+    }
+    double radius = sphere.radius * focalLength / distance;
+    double faceNumber = M_PI * radius * radius * LOD_FACES_PER_PIXEL;
+    const Model &model = object.getModel();
+    for (auto level = model.getLevelOfDetailNumber() - 1; level > 0; level--) {
+      if (model.getLevelOfDetail(level).getFaceIndices().size() >= faceNumber) {
+        objectMeshes[o] = &model.getLevelOfDetail(level);
+        renderStats.primitives.levelOfDetailReduced +=
+            object.getMesh().getFaceIndices().size() - objectMeshes[o]->getFaceIndices().size();
+        break;
+      }
+    }
+  }
+}
+void Renderer::cullOccludedObjects() {
+  const auto &objects = scene->getObjects();
+  std::vector<unsigned int> occluders;
+  for (unsigned int o = 0; o < objects.size(); o++) {
+    if (visibleObjects[o] == OBJECT_VISIBLE) {
+      occluders.push_back(o);
+    }
+  }
+  if (occluders.size() <= MAX_OCCLUDER_NUMBER) {
+    return;
+  }
+  const Vector3d &eye = camera.getEyePosition();
+  auto getDistance = [&](unsigned int o) {
+    const BoundingSphere &sphere = objects[o]->getBoundingSphere();
+    return (sphere.center - eye).norm() - sphere.radius;
+  };
+  std::nth_element(occluders.begin(), occluders.begin() + MAX_OCCLUDER_NUMBER, occluders.end(),
+                   [&](unsigned int a, unsigned int b) { return getDistance(a) < getDistance(b); });
+  occluders.resize(MAX_OCCLUDER_NUMBER);
+
+  // rasterize the depth of the occluders through the regular stages, with only the occluders visible and no shading
+  std::vector<char> visible(objects.size(), OBJECT_OUTSIDE);
+  for (auto o: occluders) {
+    visible[o] = OBJECT_VISIBLE;
+  }
+  visibleObjects.swap(visible);
+  auto counters = renderStats.primitives;
+  auto policies = passPolicies;
+  passPolicies = 0;
+  processVertices();
+  setupTriangles();
+  binTriangles();
+  threadPool->parallelFor(tiles.size(), [this](unsigned long t) { rasterizeTileVisibility(tiles[t]); });
+  visibleObjects.swap(visible);
+  // the main pass keeps the positions of the occluders instead of transforming them again
+  for (auto o: occluders) {
+    projectedObjects[o] = 1;
+  }
+  renderStats.primitives = counters;
+  passPolicies = policies;
+  triangles.clear();
+  auto imageSize = camera.getImageSize();
+  occluderDepth.resize(static_cast<unsigned long>(imageSize.first * imageSize.second));
+  threadPool->parallelFor(tiles.size(), [&](unsigned long t) {
+    Tile &tile = tiles[t];
+    tile.triangles.clear();
+    int tileWidth = tile.colEnd - tile.colBegin;
+    for (int row = tile.rowBegin; row < tile.rowEnd; row++) {
+      std::copy_n(&tile.gBuffer.depth[(row - tile.rowBegin) * tileWidth], tileWidth,
+                  &occluderDepth[row * imageSize.first + tile.colBegin]);
+    }
+  });
+  depthPyramid.build(occluderDepth, imageSize.first, imageSize.second);
+
+  // walk the hierarchy, culling whole nodes hidden behind the occluders
+  std::vector<char> isOccluder(objects.size(), 0);
+  for (auto o: occluders) {
+    isOccluder[o] = 1;
+  }
+  const auto &nodes = scene->getHierarchy().getNodes();
+  const auto &items = scene->getHierarchy().getItems();
+  auto cullObject = [&](uint32_t o) {
+    if (visibleObjects[o] == OBJECT_VISIBLE && !isOccluder[o]) {
+      visibleObjects[o] = OBJECT_OCCLUDED;
+      renderStats.primitives.objectsOccluded++;
+      renderStats.primitives.occlusionCulled += objectMeshes[o]->getIndexBuffer().size() / 3;
+    }
+  };
+  std::vector<uint32_t> stack(1, 0);
+  while (!stack.empty()) {
+    const BoundingVolumeNode &node = nodes[stack.back()];
+    stack.pop_back();
+    if (isBoxOccluded(node.box)) {
+      for (uint32_t i = node.firstItem; i < node.firstItem + node.itemNumber; i++) {
+        cullObject(items[i]);
+      }
+    } else if (node.secondChild != 0) {
+      stack.push_back(node.secondChild);
+      stack.push_back(static_cast<uint32_t>(&node - nodes.data()) + 1);
+    } else if (node.itemNumber > 1) {
+      for (uint32_t i = node.firstItem; i < node.firstItem + node.itemNumber; i++) {
+        if (isBoxOccluded(objects[items[i]]->getBoundingBox())) {
+          cullObject(items[i]);
+        }
+      }
+    }
+  }
+}
+bool Renderer::isBoxOccluded(const AxisAlignedBox &box) const {
+  if (box.isEmpty()) {
+    return false;
+  }
+  auto imageSize = camera.getImageSize();
+  double inf = std::numeric_limits<double>::infinity();
+  double xMin = inf, xMax = -inf, yMin = inf, yMax = -inf, nearest = -inf;
+  for (int corner = 0; corner < 8; corner++) {
+    Vector3d point({corner & 1 ? box.max(0) : box.min(0),
+                    corner & 2 ? box.max(1) : box.min(1),
+                    corner & 4 ? box.max(2) : box.min(2)});
+    Vector4d position = m * Utils::make4dHomoCoordPoint(point);
+    if (Clipper::getOutCode(position, imageSize.first, imageSize.second) & Clipper::CLIP_NEAR) {
+      // the screen rectangle of a box reaching behind the near plane is unbounded
+      return false;
+    }
+    Vector3d screen = Utils::homoDivideVector4d(position);
+    xMin = std::min(xMin, screen(0));
+    xMax = std::max(xMax, screen(0));
+    yMin = std::min(yMin, screen(1));
+    yMax = std::max(yMax, screen(1));
+    nearest = std::max(nearest, screen(2));
+  }
+  // pixel (i, j) lands in image row imageSize.second - j
+  auto width = static_cast<double>(imageSize.first), height = static_cast<double>(imageSize.second);
+  auto colBegin = static_cast<int>(std::floor(std::min(std::max(xMin, 0.), width)));
+  auto colEnd = static_cast<int>(std::ceil(std::min(std::max(xMax, -1.), width - 1.))) + 1;
+  auto rowBegin = static_cast<int>(std::floor(std::min(std::max(height - yMax, 0.), height)));
+  auto rowEnd = static_cast<int>(std::ceil(std::min(std::max(height - yMin, -1.), height - 1.))) + 1;
+  return depthPyramid.isOccluded(rowBegin, rowEnd, colBegin, colEnd, nearest + kOcclusionDepthBias);
+}
 void Renderer::processVertices() {
-  for (auto &object: scene->getObjects()) {
-    for (auto &vertex: object->getMesh().getVertices()) {
-      processedVertexPositions[vertex] =
-          std::make_shared<Vector4d>(m * Utils::make4dHomoCoordPoint(*vertex->position));
-      if (shadingPolicy == GOURAUD_SHADING) {
-        vertexColors[vertex] =
-            std::make_shared<ColorRGB32f>(shading(*vertex->position,
-                                                  *vertex->normal,
-                                                  scene->getLightSources(),
-                                                  *object->getColorSettings()));
+  const auto &objects = scene->getObjects();
+  processedObjects.resize(objects.size());
+  for (unsigned long o = 0; o < objects.size(); o++) {
+    if (visibleObjects[o] != OBJECT_VISIBLE) {
+      continue;
+    }
+    const Surface &object = *objects[o];
+    const TriMesh &mesh = *objectMeshes[o];
+    const SurfaceColorSettings &colorSettings = *object.getColorSettings();
+    ProcessedObject &processed = processedObjects[o];
+    const auto &positions = mesh.getPositionBuffer();
+    const auto &normals = mesh.getNormalBuffer();
+    bool gouraud = (passPolicies & 1u << GOURAUD_SHADING) != 0;
+    bool phong = (passPolicies & 1u << PHONG_SHADING) != 0;
+    // the placement of the object is folded into its matrix, and the world space attributes are only computed for
+    // the policies shading vertices or pixels
+    bool transformed = object.hasTransform();
+    Matrix4r transform = object.getTransform().cast<Real>();
+    Matrix3r normalTransform = object.getNormalTransform().cast<Real>();
+    Matrix4r objectMatrix = (transformed ? m * object.getTransform() : m).cast<Real>();
+    bool world = transformed && (gouraud || phong);
+    bool projected = projectedObjects[o] != 0;
+    processed.positions = world ? &processed.worldPositions : &positions;
+    processed.normals = world ? &processed.worldNormals : &normals;
+    processed.clipPositions.resize(positions.size());
+    processed.screenPositions.resize(positions.size());
+    if (world) {
+      processed.worldPositions.resize(positions.size());
+      processed.worldNormals.resize(positions.size());
+    }
+    if (gouraud) {
+      processed.vertexColors.resize(positions.size());
+    }
+    // the vertices and faces of the object only need the lights reaching its bounding sphere
+    std::vector<std::shared_ptr<LightSource>> lights;
+    if (passPolicies & (1u << FLAT_SHADING | 1u << GOURAUD_SHADING)) {
+      const BoundingSphere &sphere = object.getBoundingSphere();
+      for (const auto &light: scene->getLightSources()) {
+        double radius = light->getRadius();
+        if (!lightCulling || radius <= 0. || (light->getPosition() - sphere.center).norm() <= sphere.radius + radius) {
+          lights.push_back(light);
+        }
       }
     }
-    if (shadingPolicy == FLAT_SHADING) {
-      for (auto &face: object->getMesh().getFaces()) {
-        faceColors[face] =
-            std::make_shared<ColorRGB32f>(shading(*face->position,
-                                                  *face->normal,
-                                                  scene->getLightSources(),
-                                                  *object->getColorSettings()));
+    auto chunkNumber = (positions.size() + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE;
+    if (projected && !world && !gouraud) {
+      chunkNumber = 0;
+    }
+    threadPool->parallelFor(chunkNumber, [&](unsigned long chunk) {
+      auto end = std::min(positions.size(), (chunk + 1) * VERTEX_CHUNK_SIZE);
+      for (auto v = chunk * VERTEX_CHUNK_SIZE; v < end; v++) {
+        if (!projected) {
+          processed.clipPositions[v] = objectMatrix * Utils::make4dHomoCoordPoint(positions[v]);
+          processed.screenPositions[v] = Utils::homoDivideVector4d(processed.clipPositions[v]);
+        }
+        if (world) {
+          processed.worldPositions[v] =
+              Utils::homoDivideVector4d(transform * Utils::make4dHomoCoordPoint(positions[v]));
+          processed.worldNormals[v] = (normalTransform * normals[v]).normalize();
+        }
+        if (gouraud) {
+          processed.vertexColors[v] = shading((*processed.positions)[v], (*processed.normals)[v], lights,
+                                              colorSettings);
+        }
       }
+    });
+    if (passPolicies & 1u << FLAT_SHADING) {
+      const auto &facePositions = mesh.getFacePositionBuffer();
+      const auto &faceNormals = mesh.getFaceNormalBuffer();
+      processed.faceColors.resize(facePositions.size());
+      chunkNumber = (facePositions.size() + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE;
+      threadPool->parallelFor(chunkNumber, [&](unsigned long chunk) {
+        auto end = std::min(facePositions.size(), (chunk + 1) * VERTEX_CHUNK_SIZE);
+        for (auto f = chunk * VERTEX_CHUNK_SIZE; f < end; f++) {
+          if (transformed) {
+            Vector3r position = Utils::homoDivideVector4d(transform * Utils::make4dHomoCoordPoint(facePositions[f]));
+            processed.faceColors[f] = shading(position, (normalTransform * faceNormals[f]).normalize(), lights,
+                                              colorSettings);
+          } else {
+            processed.faceColors[f] = shading(facePositions[f], faceNormals[f], lights, colorSettings);
+          }
+        }
+      });
     }
   }
 }
-ColorRGB32f Renderer::shading(const Vector3d &position,
-                              const Vector3d &normal,
+ColorRGB32f Renderer::shading(const Vector3r &position,
+                              const Vector3r &normal,
                               const std::vector<std::shared_ptr<LightSource>> &lights,
-                              const SurfaceColorSettings &colorSettings) {
+                              const SurfaceColorSettings &colorSettings) const {
   ColorRGB32f result(0.f);
   result += colorSettings.kAmbient.cwiseProduct(ColorRGB32f({0.5f, 0.5f, 0.5f}));
+  // the lights are evaluated in double precision, converting the vertex once instead of every light
+  Vector3d point = position.cast<double>();
+  Vector3d direction = normal.cast<double>();
   for (auto &light: lights) {
-    Vector3d lightDirection = (light->getPosition() - position).normalize();
-    double diffuseAngle = normal.dot(lightDirection);
-    result += colorSettings.kDiffuse.cwiseProduct(light->getIntensity()) * diffuseAngle;
-    Vector3d cameraDirection = (scene->getMainCamera().getEyePosition() - position).normalize();
+    ColorRGB32f intensity = light->getIntensity() * static_cast<float>(light->getAttenuation(point));
+    Vector3d lightDirection = (light->getPosition() - point).normalize();
+    double diffuseAngle = direction.dot(lightDirection);
+    result += colorSettings.kDiffuse.cwiseProduct(intensity) * diffuseAngle;
+    Vector3d cameraDirection = (camera.getEyePosition() - point).normalize();
     Vector3d h = (lightDirection + cameraDirection).normalize();
-    double specularAngle = normal.dot(h);
-    result += colorSettings.kSpecular.cwiseProduct(light->getIntensity())
+    double specularAngle = direction.dot(h);
+    result += colorSettings.kSpecular.cwiseProduct(intensity)
         * std::pow(specularAngle, colorSettings.phongExponent);
   }
   return result;
 }
-void Renderer::rasterize() {
-  for (auto &processedVertexPosition : processedVertexPositions) {
-    dividedVertexPositions[processedVertexPosition.first] =
-        std::make_shared<Vector3d>(Utils::homoDivideVector4d(*processedVertexPosition.second));
-  }
-  for (auto &object: scene->getObjects()) {
-    auto imageSize = scene->getMainCamera().getImageSize();
-    for (auto &face: object->getMesh().getFaces()) {
-      auto vertexNeighbors = object->getMesh().getFaceVertices(face);
-      auto v0 = dividedVertexPositions[vertexNeighbors[0]];
-      auto v1 = dividedVertexPositions[vertexNeighbors[1]];
-      auto v2 = dividedVertexPositions[vertexNeighbors[2]];
-      auto xMin = static_cast<int>(std::floor(std::min({(*v0)(0), (*v1)(0), (*v2)(0)})));
-      auto xMax = static_cast<int>(std::ceil(std::max({(*v0)(0), (*v1)(0), (*v2)(0)})));
-      auto yMin = static_cast<int>(std::floor(std::min({(*v0)(1), (*v1)(1), (*v2)(1)})));
-      auto yMax = static_cast<int>(std::ceil(std::max({(*v0)(1), (*v1)(1), (*v2)(1)})));
-      if (xMin < 0 || xMax >= imageSize.first || yMin < 0 || yMin >= imageSize.second) {
+void Renderer::setupTriangles() {
+  auto imageSize = camera.getImageSize();
+  const auto &objects = scene->getObjects();
+  attributeSetups.clear();
+  for (unsigned int o = 0; o < objects.size(); o++) {
+    const auto &indices = objectMeshes[o]->getIndexBuffer();
+    if (visibleObjects[o] != OBJECT_VISIBLE) {
+      // the faces of occluded objects are already counted
+      renderStats.primitives.submitted += indices.size() / 3;
+      renderStats.primitives.frustumCulled += visibleObjects[o] == OBJECT_OUTSIDE ? indices.size() / 3 : 0;
+      continue;
+    }
+    const auto &clipPositions = processedObjects[o].clipPositions;
+    const auto &screenPositions = processedObjects[o].screenPositions;
+    renderStats.primitives.submitted += indices.size() / 3;
+    for (unsigned int f = 0; f < indices.size() / 3; f++) {
+      RasterTriangle triangle;
+      triangle.object = o;
+      triangle.face = f;
+      triangle.attributeSetup = -1;
+      unsigned int outCodes[3];
+      for (int k = 0; k < 3; k++) {
+        triangle.vertices[k] = indices[f * 3 + k];
+        outCodes[k] = Clipper::getOutCode(clipPositions[triangle.vertices[k]], imageSize.first, imageSize.second);
+      }
+      if (outCodes[0] & outCodes[1] & outCodes[2]) {
+        renderStats.primitives.frustumCulled++;
         continue;
       }
-      for (int i = xMin; i < xMax; i++) {
-        for (int j = yMin; j < yMax; j++) {
-          Vector3d baryCoord = Utils::computeBaryCoord(*v0, *v1, *v2, Vector3d({(double) i, (double) j, 0.}));
-          bool inside = true;
-          for (int i = 0; i < 3; i++) {
-            if (baryCoord(i) < -0.01 || baryCoord(1) > 1.01) {
-              inside = false;
-            }
-          }
-          if (inside) {
-            auto position = Utils::linearInterpolate(*v0, *v1, *v2, baryCoord);
-            auto pixel = std::make_pair(i, j);
-            if (zBuffer.find(pixel) != zBuffer.end() && zBuffer[pixel] > position(2)) {
-              continue;
-            }
-            auto fragment = std::make_shared<Fragment>();
-            fragment->i = imageSize.second - j;
-            fragment->j = i;
-            if (shadingPolicy == PHONG_SHADING) {
-              fragment->position = Utils::linearInterpolate(*vertexNeighbors[0]->position,
-                                                            *vertexNeighbors[1]->position,
-                                                            *vertexNeighbors[2]->position,
-                                                            baryCoord);
-              fragment->normal = Utils::linearInterpolate(*vertexNeighbors[0]->normal,
-                                                          *vertexNeighbors[1]->normal,
-                                                          *vertexNeighbors[2]->normal,
-                                                          baryCoord).normalize();
-              fragment->colorSettings = object->getColorSettings();
-            }
-            if (shadingPolicy == FLAT_SHADING) {
-              fragment->flatColor = *faceColors[face];
-            }
-            if (shadingPolicy == GOURAUD_SHADING) {
-              fragment->gouraudColor = Utils::linearInterpolate(*vertexColors[vertexNeighbors[0]],
-                                                                *vertexColors[vertexNeighbors[1]],
-                                                                *vertexColors[vertexNeighbors[2]],
-                                                                baryCoord);
-            }
-            fragments[pixel] = fragment;
-            zBuffer[pixel] = position(2);
-          }
+      if (!((outCodes[0] | outCodes[1] | outCodes[2]) & Clipper::CLIP_NEAR)) {
+        // the sides of the viewport are handled by clamping the bounding box, so only the near plane is clipped
+        addTriangle(triangle, screenPositions[triangle.vertices[0]], screenPositions[triangle.vertices[1]],
+                    screenPositions[triangle.vertices[2]], nullptr);
+        continue;
+      }
+      renderStats.primitives.nearClipped++;
+      ClipVertex polygon[4];
+      int vertexNumber = Clipper::clipNear(clipPositions[triangle.vertices[0]], clipPositions[triangle.vertices[1]],
+                                           clipPositions[triangle.vertices[2]], polygon);
+      for (int k = 1; k + 1 < vertexNumber; k++) {
+        const ClipVertex *clipVertices[3] = {&polygon[0], &polygon[k], &polygon[k + 1]};
+        addTriangle(triangle, Utils::homoDivideVector4d(polygon[0].position),
+                    Utils::homoDivideVector4d(polygon[k].position),
+                    Utils::homoDivideVector4d(polygon[k + 1].position), clipVertices);
+      }
+    }
+  }
+}
+void Renderer::addTriangle(RasterTriangle &triangle, const Vector3r &v0, const Vector3r &v1, const Vector3r &v2,
+                           const ClipVertex *clipVertices[3]) {
+  if (backFaceCulling && Clipper::getSignedArea(v0, v1, v2) < 0.) {
+    renderStats.primitives.backFaceCulled++;
+    return;
+  }
+  if (!RasterKernel::setupTriangle(v0, v1, v2, triangle.edges)) {
+    renderStats.primitives.degenerate++;
+    return;
+  }
+  // clamp before converting, vertices close to the near plane may lie far outside of the viewport
+  auto imageSize = camera.getImageSize();
+  triangle.xMin = static_cast<int>(std::floor(std::max(std::min({v0(0), v1(0), v2(0)}), Real(0))));
+  triangle.xMax = static_cast<int>(std::ceil(std::min(std::max({v0(0), v1(0), v2(0)}),
+                                                      static_cast<Real>(imageSize.first))));
+  triangle.yMin = static_cast<int>(std::floor(std::max(std::min({v0(1), v1(1), v2(1)}), Real(0))));
+  triangle.yMax = static_cast<int>(std::ceil(std::min(std::max({v0(1), v1(1), v2(1)}),
+                                                      static_cast<Real>(imageSize.second + 1))));
+  if (clipVertices != nullptr) {
+    // the barycentric coordinates relative to the face are the ones relative to the triangle, weighted by the
+    // face coordinates of the triangle vertices
+    EdgeSetup attributes = triangle.edges;
+    for (int m = 0; m < 3; m++) {
+      attributes.a[m] = attributes.b[m] = attributes.c[m] = 0.;
+      for (int k = 0; k < 3; k++) {
+        Real weight = clipVertices[k]->weights(m);
+        attributes.a[m] += weight * triangle.edges.a[k];
+        attributes.b[m] += weight * triangle.edges.b[k];
+        attributes.c[m] += weight * triangle.edges.c[k];
+      }
+    }
+    triangle.attributeSetup = static_cast<int>(attributeSetups.size());
+    attributeSetups.push_back(attributes);
+  }
+  renderStats.primitives.rasterized++;
+  triangles.push_back(triangle);
+}
+Vector3r Renderer::getFaceBaryCoord(const RasterTriangle &triangle, int x, int y) const {
+  if (triangle.attributeSetup < 0) {
+    return RasterKernel::getBaryCoord(triangle.edges, x, y);
+  }
+  return RasterKernel::getBaryCoord(attributeSetups[triangle.attributeSetup], x, y);
+}
+void Renderer::binTriangles() {
+  auto imageSize = camera.getImageSize();
+  for (unsigned int t = 0; t < triangles.size(); t++) {
+    const RasterTriangle &triangle = triangles[t];
+    // pixel (i, j) lands in image row imageSize.second - j
+    int rowBegin = std::max(imageSize.second - triangle.yMax + 1, 0);
+    int rowEnd = std::min(imageSize.second - triangle.yMin + 1, imageSize.second);
+    int colBegin = triangle.xMin;
+    int colEnd = std::min(triangle.xMax, imageSize.first);
+    if (rowBegin >= rowEnd || colBegin >= colEnd) {
+      continue;
+    }
+    for (int r = rowBegin / TILE_SIZE; r <= (rowEnd - 1) / TILE_SIZE; r++) {
+      for (int c = colBegin / TILE_SIZE; c <= (colEnd - 1) / TILE_SIZE; c++) {
+        tiles[r * tileColumns + c].triangles.push_back(t);
+      }
+    }
+  }
+}
+void Renderer::rasterize() {
+  setupTriangles();
+  binTriangles();
+  threadPool->parallelFor(tiles.size(), [this](unsigned long t) {
+    if (visibilityBuffer) {
+      rasterizeTileVisibility(tiles[t]);
+    } else {
+      rasterizeTile(tiles[t]);
+    }
+  });
+}
+void Renderer::rasterizeTile(Tile &tile) {
+  GBuffer &gBuffer = tile.gBuffer;
+  std::fill(gBuffer.depth.begin(), gBuffer.depth.end(), kEmptyDepth);
+  int imageHeight = camera.getImageSize().second;
+  int tileWidth = tile.colEnd - tile.colBegin;
+  int covered[TILE_SIZE];
+  bool flat = (passPolicies & 1u << FLAT_SHADING) != 0;
+  bool gouraud = (passPolicies & 1u << GOURAUD_SHADING) != 0;
+  bool phong = (passPolicies & 1u << PHONG_SHADING) != 0;
+  unsigned long pixelsTested = 0;
+  unsigned long depthPassed = 0;
+  for (auto t: tile.triangles) {
+    const RasterTriangle &triangle = triangles[t];
+    const ProcessedObject &processed = processedObjects[triangle.object];
+    const Vector3r *positions[3], *normals[3];
+    const ColorRGB32f *vertexColors[3];
+    for (int k = 0; k < 3; k++) {
+      positions[k] = &(*processed.positions)[triangle.vertices[k]];
+      normals[k] = &(*processed.normals)[triangle.vertices[k]];
+      vertexColors[k] = gouraud ? &processed.vertexColors[triangle.vertices[k]] : nullptr;
+    }
+    int iBegin = std::max(triangle.xMin, tile.colBegin);
+    int iEnd = std::min(triangle.xMax, tile.colEnd);
+    int jBegin = std::max(triangle.yMin, imageHeight - tile.rowEnd + 1);
+    int jEnd = std::min(triangle.yMax, imageHeight - tile.rowBegin + 1);
+    for (int j = jBegin; j < jEnd; j++) {
+      auto rowStart = (imageHeight - j - tile.rowBegin) * tileWidth - tile.colBegin;
+      int coveredNumber = coverSpan(triangle.edges, j, iBegin, iEnd, &gBuffer.depth[rowStart + iBegin], covered);
+      pixelsTested += std::max(iEnd - iBegin, 0);
+      depthPassed += coveredNumber;
+      for (int c = 0; c < coveredNumber; c++) {
+        int i = covered[c];
+        auto pixel = rowStart + i;
+        Vector3r baryCoord = getFaceBaryCoord(triangle, i, j);
+        if (phong) {
+          auto position = Utils::linearInterpolate(*positions[0],
+                                                   *positions[1],
+                                                   *positions[2],
+                                                   baryCoord);
+          auto normal = Utils::linearInterpolate(*normals[0],
+                                                 *normals[1],
+                                                 *normals[2],
+                                                 baryCoord).normalize();
+          gBuffer.positionX[pixel] = static_cast<float>(position(0));
+          gBuffer.positionY[pixel] = static_cast<float>(position(1));
+          gBuffer.positionZ[pixel] = static_cast<float>(position(2));
+          gBuffer.normalX[pixel] = static_cast<float>(normal(0));
+          gBuffer.normalY[pixel] = static_cast<float>(normal(1));
+          gBuffer.normalZ[pixel] = static_cast<float>(normal(2));
+          gBuffer.materials[pixel] = triangle.object;
+        }
+        if (flat) {
+          gBuffer.flatColors[pixel] = processed.faceColors[triangle.face];
+        }
+        if (gouraud) {
+          gBuffer.gouraudColors[pixel] = Utils::linearInterpolate(*vertexColors[0],
+                                                                  *vertexColors[1],
+                                                                  *vertexColors[2],
+                                                                  baryCoord);
         }
+        gBuffer.depth[pixel] = RasterKernel::getDepth(triangle.edges, i, j);
       }
     }
   }
+  tile.pixelsTested = pixelsTested;
+  tile.depthPassed = depthPassed;
 }
-Renderer::Renderer(const std::string &inputSceneFileName) {
-  scene = std::make_shared<Scene>(inputSceneFileName);
+void Renderer::rasterizeTileVisibility(Tile &tile) {
+  GBuffer &gBuffer = tile.gBuffer;
+  std::fill(gBuffer.depth.begin(), gBuffer.depth.end(), kEmptyDepth);
+  int imageHeight = camera.getImageSize().second;
+  int tileWidth = tile.colEnd - tile.colBegin;
+  int covered[TILE_SIZE];
+  unsigned long pixelsTested = 0;
+  unsigned long depthPassed = 0;
+  for (auto t: tile.triangles) {
+    const RasterTriangle &triangle = triangles[t];
+    int iBegin = std::max(triangle.xMin, tile.colBegin);
+    int iEnd = std::min(triangle.xMax, tile.colEnd);
+    int jBegin = std::max(triangle.yMin, imageHeight - tile.rowEnd + 1);
+    int jEnd = std::min(triangle.yMax, imageHeight - tile.rowBegin + 1);
+    for (int j = jBegin; j < jEnd; j++) {
+      auto rowStart = (imageHeight - j - tile.rowBegin) * tileWidth - tile.colBegin;
+      int coveredNumber = coverSpan(triangle.edges, j, iBegin, iEnd, &gBuffer.depth[rowStart + iBegin], covered);
+      pixelsTested += std::max(iEnd - iBegin, 0);
+      depthPassed += coveredNumber;
+      for (int c = 0; c < coveredNumber; c++) {
+        int i = covered[c];
+        gBuffer.visibility[rowStart + i] = t;
+        gBuffer.depth[rowStart + i] = RasterKernel::getDepth(triangle.edges, i, j);
+      }
+    }
+  }
+  tile.pixelsTested = pixelsTested;
+  tile.depthPassed = depthPassed;
+}
+Renderer::Renderer(const std::string &inputSceneFileName) : Renderer(std::make_shared<Scene>(inputSceneFileName)) {
+}
+Renderer::Renderer(const std::shared_ptr<Scene> &scene)
+    : scene(scene), camera(scene->getMainCamera()), tileColumns(0), bufferSize(0, 0), shadingPolicyMask(0),
+      passPolicies(0), renderedPolicies(0) {
+  threadPool = std::make_shared<ThreadPool>(0);
+  setInstructionSet(RasterKernel::detectInstructionSet());
+  visibilityBuffer = false;
+  backFaceCulling = false;
+  occlusionCulling = true;
+  levelOfDetail = true;
+  lightCulling = true;
+  verbose = true;
   shadingPolicy = FLAT_SHADING;
-  frameBuffer = std::make_shared<Image32f>();
+  for (int policy = 0; policy < SHADING_POLICY_NUMBER; policy++) {
+    frameBuffers.push_back(std::make_shared<Image32f>());
+    images.push_back(nullptr);
+  }
 }
 int Renderer::getShadingPolicy() const {
   return shadingPolicy;
@@ -149,48 +641,332 @@ int Renderer::getShadingPolicy() const {
 void Renderer::setShadingPolicy(int shadingPolicy) {
   Renderer::shadingPolicy = shadingPolicy;
 }
+unsigned int Renderer::getShadingPolicyMask() const {
+  return shadingPolicyMask;
+}
+void Renderer::setShadingPolicyMask(unsigned int shadingPolicyMask) {
+  Renderer::shadingPolicyMask = shadingPolicyMask & ALL_SHADING_POLICIES;
+}
+unsigned int Renderer::getThreadNumber() const {
+  return threadPool->getThreadNumber();
+}
+void Renderer::setThreadNumber(unsigned int threadNumber) {
+  threadPool = std::make_shared<ThreadPool>(threadNumber);
+}
+int Renderer::getInstructionSet() const {
+  return instructionSet;
+}
+void Renderer::setInstructionSet(int instructionSet) {
+  Renderer::instructionSet = instructionSet;
+  coverSpan = RasterKernel::getSpanFunction(static_cast<RasterKernel::InstructionSet>(instructionSet));
+}
+bool Renderer::isVisibilityBufferEnabled() const {
+  return visibilityBuffer;
+}
+void Renderer::setVisibilityBufferEnabled(bool visibilityBuffer) {
+  Renderer::visibilityBuffer = visibilityBuffer;
+}
+bool Renderer::isBackFaceCullingEnabled() const {
+  return backFaceCulling;
+}
+void Renderer::setBackFaceCullingEnabled(bool backFaceCulling) {
+  if (backFaceCulling != Renderer::backFaceCulling) {
+    renderedPolicies = 0;
+  }
+  Renderer::backFaceCulling = backFaceCulling;
+}
+const PrimitiveCounters &Renderer::getPrimitiveCounters() const {
+  return renderStats.primitives;
+}
+const StageTimes &Renderer::getStageTimes() const {
+  return renderStats.times;
+}
+const RenderStats &Renderer::getRenderStats() const {
+  return renderStats;
+}
+bool Renderer::isOcclusionCullingEnabled() const {
+  return occlusionCulling;
+}
+void Renderer::setOcclusionCullingEnabled(bool occlusionCulling) {
+  Renderer::occlusionCulling = occlusionCulling;
+}
+bool Renderer::isLevelOfDetailEnabled() const {
+  return levelOfDetail;
+}
+void Renderer::setLevelOfDetailEnabled(bool levelOfDetail) {
+  if (levelOfDetail != Renderer::levelOfDetail) {
+    renderedPolicies = 0;
+  }
+  Renderer::levelOfDetail = levelOfDetail;
+}
+bool Renderer::isLightCullingEnabled() const {
+  return lightCulling;
+}
+void Renderer::setLightCullingEnabled(bool lightCulling) {
+  Renderer::lightCulling = lightCulling;
+}
+const Camera &Renderer::getCamera() const {
+  return camera;
+}
+void Renderer::setCamera(const Camera &camera) {
+  renderedPolicies = 0;
+  Renderer::camera = camera;
+}
+bool Renderer::isVerbose() const {
+  return verbose;
+}
+void Renderer::setVerbose(bool verbose) {
+  Renderer::verbose = verbose;
+}
 std::shared_ptr<Image8i> Renderer::renderForDisplay() {
-  std::cout << "Rendering using ";
-  switch (shadingPolicy) {
-    case GOURAUD_SHADING:std::cout << "Gourand shading." << std::endl;
-      break;
-    case PHONG_SHADING:std::cout << "Phong shading." << std::endl;
-      break;
-    case FLAT_SHADING:
-    default:std::cout << "flat shading." << std::endl;
-      break;
-  }
-  vertexColors.clear();
-  faceColors.clear();
-  fragments.clear();
-  zBuffer.clear();
-  prepareMatrices();
-  processVertices();
-  rasterize();
-  fragmentShading();
-  return ImageUtils::convertFloatImage2Int(*frameBuffer);
+  if (renderedPolicies & 1u << shadingPolicy) {
+    return images[shadingPolicy];
+  }
+  passPolicies = shadingPolicyMask | 1u << shadingPolicy;
+  if (verbose) {
+    std::cout << "Rendering using ";
+    const char *separator = "";
+    for (int policy = 0; policy < SHADING_POLICY_NUMBER; policy++) {
+      if (!(passPolicies & 1u << policy)) {
+        continue;
+      }
+      std::cout << separator;
+      separator = ", ";
+      switch (policy) {
+        case GOURAUD_SHADING:std::cout << "Gourand shading";
+          break;
+        case PHONG_SHADING:std::cout << "Phong shading";
+          break;
+        case FLAT_SHADING:
+        default:std::cout << "flat shading";
+          break;
+      }
+    }
+    std::cout << "." << std::endl;
+  }
+  TRACE_SCOPE("renderForDisplay");
+  // run a stage of the pipeline, measuring its time
+  auto runStage = [](const char *name, double &seconds, const std::function<void()> &stage) {
+    TRACE_SCOPE(name);
+    auto start = std::chrono::steady_clock::now();
+    stage();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+  runStage("prepareBuffers", renderStats.times.prepareBuffers, [this] { prepareBuffers(); });
+  runStage("prepareMatrices", renderStats.times.prepareMatrices, [this] { prepareMatrices(); });
+  runStage("cullObjects", renderStats.times.cullObjects, [this] { cullObjects(); });
+  runStage("processVertices", renderStats.times.processVertices, [this] { processVertices(); });
+  runStage("rasterize", renderStats.times.rasterize, [this] { rasterize(); });
+  runStage("fragmentShading", renderStats.times.fragmentShading, [this] { fragmentShading(); });
+  runStage("convert", renderStats.times.convert, [this] {
+    for (int policy = 0; policy < SHADING_POLICY_NUMBER; policy++) {
+      if (passPolicies & 1u << policy) {
+        images[policy] = ImageUtils::convertFloatImage2Int(*frameBuffers[policy]);
+      }
+    }
+  });
+  updateRenderStats();
+  renderedPolicies |= passPolicies;
+  return images[shadingPolicy];
+}
+void Renderer::invalidateImages() {
+  renderedPolicies = 0;
+}
+std::shared_ptr<Image8i> Renderer::getImage(int shadingPolicy) const {
+  return renderedPolicies & 1u << shadingPolicy ? images[shadingPolicy] : nullptr;
 }
 void Renderer::fragmentShading() {
-  auto imageSize = scene->getMainCamera().getImageSize();
-  frameBuffer->resize(static_cast<unsigned long>(imageSize.second),
-                      static_cast<unsigned long>(imageSize.first), ColorRGB32f(0.f));
-  ImageUtils::clearImage(*frameBuffer);
-  for (auto &fragmentPair: fragments) {
-    auto fragment = fragmentPair.second;
-    switch (shadingPolicy) {
-      case GOURAUD_SHADING:(*frameBuffer)(fragment->i, fragment->j) = fragment->gouraudColor;
-        break;
-      case PHONG_SHADING:
-        (*frameBuffer)(fragment->i, fragment->j) =
-            shading(fragment->position,
-                    fragment->normal,
-                    scene->getLightSources(),
-                    *fragment->colorSettings);
-        break;
-      case FLAT_SHADING:
-      default:(*frameBuffer)(fragment->i, fragment->j) = fragment->flatColor;
-        break;
+  bool phong = (passPolicies & 1u << PHONG_SHADING) != 0;
+  if (phong) {
+    ShadingKernel::packConstants(*scene, camera.getEyePosition(), shadingConstants);
+  }
+  threadPool->parallelFor(tiles.size(), [this, phong](unsigned long t) {
+    if (phong) {
+      cullTileLights(tiles[t]);
+    }
+    for (int policy = 0; policy < SHADING_POLICY_NUMBER; policy++) {
+      if (passPolicies & 1u << policy) {
+        shadeTile(tiles[t], policy);
+      }
+    }
+  });
+}
+void Renderer::cullTileLights(Tile &tile) {
+  const auto &lights = scene->getLightSources();
+  tile.lights.clear();
+  // world space box of the positions shaded in the tile, which the shading kernel interpolates from the vertices of
+  // the visible triangles
+  AxisAlignedBox box;
+  if (lightCulling) {
+    const GBuffer &gBuffer = tile.gBuffer;
+    auto lastTriangle = std::numeric_limits<uint32_t>::max();
+    for (unsigned long pixel = 0; pixel < gBuffer.depth.size(); pixel++) {
+      if (gBuffer.depth[pixel] == kEmptyDepth) {
+        continue;
+      }
+      if (!visibilityBuffer) {
+        box.extend(Vector3d({gBuffer.positionX[pixel], gBuffer.positionY[pixel], gBuffer.positionZ[pixel]}));
+      } else if (gBuffer.visibility[pixel] != lastTriangle) {
+        lastTriangle = gBuffer.visibility[pixel];
+        const RasterTriangle &triangle = triangles[lastTriangle];
+        const auto &positions = *processedObjects[triangle.object].positions;
+        for (auto vertex: triangle.vertices) {
+          box.extend(positions[vertex].cast<double>());
+        }
+      }
+    }
+    if (box.isEmpty()) {
+      return;
+    }
+  }
+  for (unsigned int l = 0; l < lights.size(); l++) {
+    double radius = lights[l]->getRadius();
+    if (!lightCulling || radius <= 0.
+        || box.getSquaredDistance(lights[l]->getPosition()) <= radius * radius * (1. + LIGHT_RADIUS_MARGIN)) {
+      tile.lights.push_back(l);
     }
   }
 }
+void Renderer::updateRenderStats() {
+  renderStats.verticesTransformed = 0;
+  for (unsigned long o = 0; o < objectMeshes.size(); o++) {
+    if (visibleObjects[o] == OBJECT_VISIBLE) {
+      renderStats.verticesTransformed += objectMeshes[o]->getPositionBuffer().size();
+    }
+  }
+  renderStats.pixelsTested = 0;
+  renderStats.depthPassed = 0;
+  renderStats.fragments = 0;
+  renderStats.lightEvaluations = 0;
+  bool phong = (passPolicies & 1u << PHONG_SHADING) != 0;
+  for (const auto &tile: tiles) {
+    renderStats.pixelsTested += tile.pixelsTested;
+    renderStats.depthPassed += tile.depthPassed;
+    renderStats.fragments += tile.fragmentNumber;
+    renderStats.lightEvaluations += phong ? tile.fragmentNumber * tile.lights.size() : 0;
+  }
+  unsigned long policyNumber = 0;
+  for (int policy = 0; policy < SHADING_POLICY_NUMBER; policy++) {
+    policyNumber += passPolicies >> policy & 1u;
+  }
+  renderStats.fragmentsShaded = renderStats.fragments * policyNumber;
+  renderStats.overdraw = renderStats.fragments > 0
+                         ? static_cast<double>(renderStats.depthPassed) / renderStats.fragments : 0.;
 
+  // capacity of the buffers of every stage
+  auto getBytes = [](const auto &buffer) {
+    return static_cast<unsigned long>(buffer.capacity() * sizeof(buffer[0]));
+  };
+  auto getImageBytes = [](const auto &images, unsigned long pixelBytes) {
+    unsigned long bytes = 0;
+    for (const auto &image: images) {
+      bytes += image ? image->rows() * image->cols() * pixelBytes : 0;
+    }
+    return bytes;
+  };
+  StageBytes &bytes = renderStats.bytes;
+  bytes = StageBytes();
+  for (const auto &tile: tiles) {
+    const GBuffer &gBuffer = tile.gBuffer;
+    bytes.prepareBuffers += getBytes(gBuffer.depth) + getBytes(gBuffer.visibility) + getBytes(gBuffer.flatColors)
+        + getBytes(gBuffer.gouraudColors) + getBytes(gBuffer.positionX) + getBytes(gBuffer.positionY)
+        + getBytes(gBuffer.positionZ) + getBytes(gBuffer.normalX) + getBytes(gBuffer.normalY)
+        + getBytes(gBuffer.normalZ) + getBytes(gBuffer.materials);
+    bytes.rasterize += getBytes(tile.triangles);
+    bytes.fragmentShading += getBytes(tile.lights);
+  }
+  bytes.prepareBuffers += getImageBytes(frameBuffers, sizeof(ColorRGB32f));
+  bytes.cullObjects = getBytes(visibleObjects) + getBytes(objectMeshes) + getBytes(occluderDepth);
+  for (const auto &processed: processedObjects) {
+    bytes.processVertices += getBytes(processed.clipPositions) + getBytes(processed.screenPositions)
+        + getBytes(processed.vertexColors) + getBytes(processed.faceColors) + getBytes(processed.worldPositions)
+        + getBytes(processed.worldNormals);
+  }
+  bytes.rasterize += getBytes(triangles) + getBytes(attributeSetups);
+  bytes.fragmentShading += getBytes(shadingConstants.lightX) + getBytes(shadingConstants.lightY)
+      + getBytes(shadingConstants.lightZ) + getBytes(shadingConstants.lightRed) + getBytes(shadingConstants.lightGreen)
+      + getBytes(shadingConstants.lightBlue) + getBytes(shadingConstants.lightInverseSquaredRadius)
+      + getBytes(shadingConstants.materials);
+  bytes.convert = getImageBytes(images, sizeof(ColorRGB8i));
+}
+void Renderer::shadeTile(Tile &tile, int policy) {
+  const int batchSize = ShadingKernel::BATCH_SIZE;
+  const GBuffer &gBuffer = tile.gBuffer;
+  auto *pixels = frameBuffers[policy]->getRawData();
+  auto imageWidth = frameBuffers[policy]->cols();
+  unsigned long batchPixels[batchSize];
+  float positions[3][batchSize] = {}, normals[3][batchSize] = {}, colors[3][batchSize];
+  unsigned int materials[batchSize] = {};
+  int batchCount = 0;
+  auto flushBatch = [&]() {
+    ShadingKernel::shadeBatch(shadingConstants, tile.lights, batchCount, positions, normals, materials, colors);
+    for (int lane = 0; lane < batchCount; lane++) {
+      pixels[batchPixels[lane]] = ColorRGB32f({colors[0][lane], colors[1][lane], colors[2][lane]});
+    }
+    batchCount = 0;
+  };
+  int imageHeight = static_cast<int>(frameBuffers[policy]->rows());
+  unsigned long pixel = 0;
+  unsigned long fragmentNumber = 0;
+  for (int row = tile.rowBegin; row < tile.rowEnd; row++) {
+    for (int col = tile.colBegin; col < tile.colEnd; col++, pixel++) {
+      auto imagePixel = row * imageWidth + col;
+      if (gBuffer.depth[pixel] == kEmptyDepth) {
+        pixels[imagePixel] = ColorRGB32f(0.f);
+        continue;
+      }
+      fragmentNumber++;
+      if (visibilityBuffer) {
+        // rebuild the attributes of the visible triangle, exactly like rasterizeTile() computes them
+        const RasterTriangle &triangle = triangles[gBuffer.visibility[pixel]];
+        const ProcessedObject &processed = processedObjects[triangle.object];
+        Vector3r baryCoord = getFaceBaryCoord(triangle, col, imageHeight - row);
+        if (policy == FLAT_SHADING) {
+          pixels[imagePixel] = processed.faceColors[triangle.face];
+          continue;
+        }
+        if (policy == GOURAUD_SHADING) {
+          pixels[imagePixel] = Utils::linearInterpolate(processed.vertexColors[triangle.vertices[0]],
+                                                        processed.vertexColors[triangle.vertices[1]],
+                                                        processed.vertexColors[triangle.vertices[2]],
+                                                        baryCoord);
+          continue;
+        }
+        const auto &objectPositions = *processed.positions;
+        const auto &objectNormals = *processed.normals;
+        auto position = Utils::linearInterpolate(objectPositions[triangle.vertices[0]],
+                                                 objectPositions[triangle.vertices[1]],
+                                                 objectPositions[triangle.vertices[2]],
+                                                 baryCoord);
+        auto normal = Utils::linearInterpolate(objectNormals[triangle.vertices[0]],
+                                               objectNormals[triangle.vertices[1]],
+                                               objectNormals[triangle.vertices[2]],
+                                               baryCoord).normalize();
+        for (int k = 0; k < 3; k++) {
+          positions[k][batchCount] = static_cast<float>(position(k));
+          normals[k][batchCount] = static_cast<float>(normal(k));
+        }
+        materials[batchCount] = triangle.object;
+      } else if (policy != PHONG_SHADING) {
+        pixels[imagePixel] = policy == FLAT_SHADING ? gBuffer.flatColors[pixel] : gBuffer.gouraudColors[pixel];
+        continue;
+      } else {
+        positions[0][batchCount] = gBuffer.positionX[pixel];
+        positions[1][batchCount] = gBuffer.positionY[pixel];
+        positions[2][batchCount] = gBuffer.positionZ[pixel];
+        normals[0][batchCount] = gBuffer.normalX[pixel];
+        normals[1][batchCount] = gBuffer.normalY[pixel];
+        normals[2][batchCount] = gBuffer.normalZ[pixel];
+        materials[batchCount] = gBuffer.materials[pixel];
+      }
+      batchPixels[batchCount] = imagePixel;
+      if (++batchCount == batchSize) {
+        flushBatch();
+      }
+    }
+  }
+  if (batchCount > 0) {
+    flushBatch();
+  }
+  tile.fragmentNumber = fragmentNumber;
+}
@@ -7,14 +7,154 @@
 
 #include "Scene.h"
 #include "Image.h"
-struct Fragment{
-  int i, j;
-  Vector3d position;
-  Vector3d normal;
-  ColorRGB32f flatColor;
-  ColorRGB32f gouraudColor;
-  ColorRGB32f phongColor;
-  std::shared_ptr<SurfaceColorSettings> colorSettings;
+#include "ThreadPool.h"
+#include "RasterKernel.h"
+#include "ShadingKernel.h"
+#include "Clipper.h"
+#include "DepthPyramid.h"
+/// Per-pixel rasterization results of a tile, stored as structure of arrays in row-major tile order.
+struct GBuffer {
+  /// resize the planes
+  /// \param pixelNumber
+  /// \param attributes whether the attribute planes are needed, otherwise only depth and visibility are kept
+  void resize(unsigned long pixelNumber, bool attributes);
+  std::vector<Real> depth;
+  /// index of the frame triangle covering the pixel, only written in visibility buffer mode
+  std::vector<uint32_t> visibility;
+  /// resolved colors of flat and Gouraud shading
+  std::vector<ColorRGB32f> flatColors, gouraudColors;
+  /// world space position, unit normal and material index of Phong shading
+  std::vector<float> positionX, positionY, positionZ;
+  std::vector<float> normalX, normalY, normalZ;
+  std::vector<unsigned int> materials;
+};
+
+/// Screen space triangle with everything needed to rasterize it, set up once per frame.
+struct RasterTriangle {
+  /// index of the object in the scene, also used to look up its material
+  unsigned int object;
+  /// index of the face in the object mesh
+  unsigned int face;
+  uint32_t vertices[3];
+  EdgeSetup edges;
+  /// index into the attribute setups of a triangle cut out of its face by the near plane, whose barycentric
+  /// coordinates relative to the face differ from the ones of its edges. -1 for a whole face.
+  int attributeSetup;
+  /// bounding box clamped to the viewport
+  int xMin, xMax, yMin, yMax;
+};
+
+/// Number of triangles entering and leaving the primitive stage in the last render
+struct PrimitiveCounters {
+  /// faces of all objects, at the level of detail they are rendered with
+  unsigned long submitted = 0;
+  /// faces saved by rendering objects at coarser levels of detail
+  unsigned long levelOfDetailReduced = 0;
+  /// objects outside of the view frustum, skipped before the vertex stage
+  unsigned long objectsCulled = 0;
+  /// faces entirely outside of one plane of the view frustum, including the faces of the culled objects
+  unsigned long frustumCulled = 0;
+  /// objects hidden behind the occluders, skipped before the vertex stage
+  unsigned long objectsOccluded = 0;
+  /// faces of the objects hidden behind the occluders
+  unsigned long occlusionCulled = 0;
+  /// faces turning their back to the camera
+  unsigned long backFaceCulled = 0;
+  /// faces or clipped triangles of zero screen area
+  unsigned long degenerate = 0;
+  /// faces crossing the near plane, which are clipped into one or two triangles
+  unsigned long nearClipped = 0;
+  /// triangles passed to the rasterizer
+  unsigned long rasterized = 0;
+};
+
+/// Wall clock time of the stages of the last render in seconds
+struct StageTimes {
+  /// allocation and clearing of the tiles and frame buffers
+  double prepareBuffers = 0.;
+  double prepareMatrices = 0.;
+  /// frustum culling, level of detail selection and occlusion culling
+  double cullObjects = 0.;
+  double processVertices = 0.;
+  /// triangle setup, binning and rasterization of the tiles
+  double rasterize = 0.;
+  double fragmentShading = 0.;
+  /// conversion of the floating point images to 8-bit images
+  double convert = 0.;
+};
+
+/// Bytes of the buffers of the stages after the last render. The buffers are kept and reused by the next renders,
+/// so they only grow when a render needs more of them.
+struct StageBytes {
+  /// G-buffers of the tiles and floating point images
+  unsigned long prepareBuffers = 0;
+  /// object visibility, selected levels of detail and occluder depth
+  unsigned long cullObjects = 0;
+  /// vertex stage results of the objects
+  unsigned long processVertices = 0;
+  /// set up triangles and triangle lists of the tiles
+  unsigned long rasterize = 0;
+  /// packed lights and materials of the shading kernel, and the light lists of the tiles
+  unsigned long fragmentShading = 0;
+  /// 8-bit images
+  unsigned long convert = 0;
+};
+
+/// Statistics of the last render. The pixel and fragment counts leave out the occluders rendered for occlusion
+/// culling.
+struct RenderStats {
+  PrimitiveCounters primitives;
+  /// vertices of the rendered objects run through the vertex stage
+  unsigned long verticesTransformed = 0;
+  /// pixels of the triangle bounding boxes tested for coverage and depth
+  unsigned long pixelsTested = 0;
+  /// covered pixels nearer than the pixels drawn before them, each written to the G-buffer
+  unsigned long depthPassed = 0;
+  /// pixels covered by the rasterized triangles
+  unsigned long fragments = 0;
+  /// fragments shaded by all shading policies of the pass
+  unsigned long fragmentsShaded = 0;
+  /// number of times every covered pixel was written on average, depthPassed / fragments
+  double overdraw = 0.;
+  /// lights evaluated by the Phong shading of the fragments
+  unsigned long lightEvaluations = 0;
+  StageTimes times;
+  StageBytes bytes;
+  /// get the statistics as a JSON object on a single line
+  /// \return
+  std::string toJson() const;
+};
+
+/// Per-object results of the vertex stage, indexed like the vertex and face buffers of the mesh.
+struct ProcessedObject {
+  /// homogeneous screen space positions, w > 0 in front of the camera
+  std::vector<Vector4r> clipPositions;
+  std::vector<Vector3r> screenPositions;
+  std::vector<ColorRGB32f> vertexColors;
+  std::vector<ColorRGB32f> faceColors;
+  /// world space vertex positions and normals, the buffers of the mesh for objects without transformation
+  const std::vector<Vector3r> *positions = nullptr;
+  const std::vector<Vector3r> *normals = nullptr;
+  /// transformed vertex positions and normals of objects placed by a transformation
+  std::vector<Vector3r> worldPositions;
+  std::vector<Vector3r> worldNormals;
+};
+
+/// Rectangular block of the image, rasterized and shaded independently of the other tiles.
+/// Each tile owns the G-buffer of its pixels, so tiles never share memory while rendering.
+struct Tile {
+  /// image rows [rowBegin, rowEnd) and columns [colBegin, colEnd) covered by the tile
+  int rowBegin, rowEnd, colBegin, colEnd;
+  /// indices of the triangles overlapping the tile, in submission order
+  std::vector<unsigned int> triangles;
+  GBuffer gBuffer;
+  /// pixels of the tile covered by a triangle in the last render
+  unsigned long fragmentNumber = 0;
+  /// pixels of the triangle bounding boxes tested, and the ones passing the depth test, in the last render
+  unsigned long pixelsTested = 0;
+  unsigned long depthPassed = 0;
+  /// indices of the lights of the scene reaching the fragments of the tile, built for Phong shading
+  std::vector<unsigned int> lights;
 };
 
 /// Rasterizing Renderer
@@ -23,39 +163,196 @@ class Renderer {
   enum ShadingPolicy {
     FLAT_SHADING,
     GOURAUD_SHADING,
-    PHONG_SHADING
+    PHONG_SHADING,
+    SHADING_POLICY_NUMBER
   };
+  /// mask of every shading policy, see setShadingPolicyMask()
+  static const unsigned int ALL_SHADING_POLICIES = (1u << SHADING_POLICY_NUMBER) - 1;
+  /// edge length of the square screen tiles in pixels
+  static const int TILE_SIZE = 32;
+  /// number of vertices or faces processed by one vertex stage task
+  static const unsigned long VERTEX_CHUNK_SIZE = 4096;
+  /// number of objects nearest to the camera rendered into the depth pyramid for occlusion culling
+  static const unsigned long MAX_OCCLUDER_NUMBER = 16;
+  /// faces of a level of detail needed per pixel covered by the object, see setLevelOfDetailEnabled()
+  static constexpr double LOD_FACES_PER_PIXEL = 1.;
+  /// relative margin added to the squared radius of the lights when culling them, covering the rounding of the
+  /// single precision positions of the shading kernel
+  static constexpr double LIGHT_RADIUS_MARGIN = 1e-4;
   /// Construct the renderer using the input scene file
   /// \param inputSceneFileName
   explicit Renderer(const std::string &inputSceneFileName);
-  /// Render the scene
-  /// \return the rendered 8-bit image
+  /// Construct the renderer of a loaded scene
+  /// \param scene
+  explicit Renderer(const std::shared_ptr<Scene> &scene);
+  /// Render the scene with the current shading policy and the policies of the policy mask in one pass. Images
+  /// rendered before are reused, so switching to a policy rendered along with an earlier one costs nothing.
+  /// \return the rendered 8-bit image of the current shading policy
   std::shared_ptr<Image8i> renderForDisplay();
+  /// discard the images rendered so far, so that the next render renders the scene again
+  void invalidateImages();
+  /// get the image of a shading policy from the last renders
+  /// \param shadingPolicy
+  /// \return nullptr if the policy has not been rendered
+  std::shared_ptr<Image8i> getImage(int shadingPolicy) const;
   /// get the shading method
   /// \return one of the shading method defined in the ShadingPolicy enum
   int getShadingPolicy() const;
   /// set the shading method
   /// \param shadingPolicy
   void setShadingPolicy(int shadingPolicy);
+  /// get the shading policies rendered in addition to the current one
+  /// \return bit (1 << policy) set for every policy
+  unsigned int getShadingPolicyMask() const;
+  /// set the shading policies rendered in addition to the current one. They share the vertex transformation,
+  /// rasterization and depth test of a single pass.
+  /// \param shadingPolicyMask bit (1 << policy) set for every policy, ALL_SHADING_POLICIES for all of them
+  void setShadingPolicyMask(unsigned int shadingPolicyMask);
+  /// get the number of threads used for rendering
+  /// \return
+  unsigned int getThreadNumber() const;
+  /// set the number of threads used for rendering
+  /// \param threadNumber 0 uses all hardware threads
+  void setThreadNumber(unsigned int threadNumber);
+  /// get the instruction set of the rasterization kernel, picked from the running CPU by default
+  /// \return one of the instruction sets defined in the RasterKernel::InstructionSet enum
+  int getInstructionSet() const;
+  /// set the instruction set of the rasterization kernel. Every instruction set renders the same image.
+  /// \param instructionSet must be supported by the running CPU
+  void setInstructionSet(int instructionSet);
+  /// whether the visibility buffer mode is enabled
+  /// \return
+  bool isVisibilityBufferEnabled() const;
+  /// enable or disable the visibility buffer mode. In this mode rasterization only stores the depth and the triangle
+  /// covering each pixel, and the shading pass rebuilds the attributes of the visible pixels from the triangles.
+  /// Overdrawn pixels then cost no attribute work. Both modes render the same image.
+  /// \param visibilityBuffer
+  void setVisibilityBufferEnabled(bool visibilityBuffer);
+  /// whether faces turning their back to the camera are culled
+  /// \return
+  bool isBackFaceCullingEnabled() const;
+  /// enable or disable back-face culling. The front faces of a mesh are the ones appearing counterclockwise on the
+  /// screen, and culling the others only leaves the image unchanged for closed and consistently oriented meshes.
+  /// \param backFaceCulling
+  void setBackFaceCullingEnabled(bool backFaceCulling);
+  /// get the triangle counters of the primitive stage of the last render
+  /// \return
+  const PrimitiveCounters &getPrimitiveCounters() const;
+  /// get the time spent in every stage of the last render
+  /// \return
+  const StageTimes &getStageTimes() const;
+  /// get the statistics of the last render, including its triangle counters and stage times
+  /// \return
+  const RenderStats &getRenderStats() const;
+  /// whether objects hidden behind the objects nearest to the camera are culled
+  /// \return
+  bool isOcclusionCullingEnabled() const;
+  /// enable or disable occlusion culling. When more than MAX_OCCLUDER_NUMBER objects are in view, the nearest ones
+  /// are rasterized into a hierarchical depth buffer first, and the bounding boxes of the hierarchy nodes and of the
+  /// other objects are tested against it. Only objects that cannot cover any pixel are culled, so the image does not
+  /// change.
+  /// \param occlusionCulling
+  void setOcclusionCullingEnabled(bool occlusionCulling);
+  /// whether objects are rendered at a level of detail picked from their size on the screen
+  /// \return
+  bool isLevelOfDetailEnabled() const;
+  /// enable or disable the levels of detail. When enabled, every visible object is rendered with its coarsest level
+  /// of detail that still has LOD_FACES_PER_PIXEL faces per pixel of the disk its bounding sphere projects to.
+  /// Objects are otherwise always rendered with their full meshes.
+  /// \param levelOfDetail
+  void setLevelOfDetailEnabled(bool levelOfDetail);
+  /// whether the lights reaching a limited distance are culled
+  /// \return
+  bool isLightCullingEnabled() const;
+  /// enable or disable light culling, enabled by default. Phong shading then only evaluates, in every tile, the lights
+  /// reaching the box around the positions shaded in the tile, and flat and Gouraud shading only evaluate, for every
+  /// object, the lights reaching its bounding sphere. The culled lights do not reach the shaded points, so the image
+  /// does not change.
+  /// \param lightCulling
+  void setLightCullingEnabled(bool lightCulling);
+  /// get the camera the scene is rendered from, the main camera of the scene unless set
+  /// \return
+  const Camera &getCamera() const;
+  /// set the camera the scene is rendered from, leaving the scene unchanged. Renderers sharing a scene can render
+  /// it from different cameras at the same time.
+  /// \param camera
+  void setCamera(const Camera &camera);
+  /// whether every render reports the shading policies it renders on the standard output
+  /// \return
+  bool isVerbose() const;
+  /// enable or disable the report of every render, enabled by default
+  /// \param verbose
+  void setVerbose(bool verbose);
  private:
+  void prepareBuffers();
   void prepareMatrices();
+  void cullObjects();
+  void cullOccludedObjects();
+  void selectLevelsOfDetail();
+  bool isBoxOccluded(const AxisAlignedBox &box) const;
   void processVertices();
+  void setupTriangles();
+  void addTriangle(RasterTriangle &triangle, const Vector3r &v0, const Vector3r &v1, const Vector3r &v2,
+                   const ClipVertex *clipVertices[3]);
+  Vector3r getFaceBaryCoord(const RasterTriangle &triangle, int x, int y) const;
+  void binTriangles();
   void rasterize();
+  void rasterizeTile(Tile &tile);
+  void rasterizeTileVisibility(Tile &tile);
   void fragmentShading();
-  ColorRGB32f shading(const Vector3d &position,
-                        const Vector3d &normal,
+  void cullTileLights(Tile &tile);
+  void updateRenderStats();
+  void shadeTile(Tile &tile, int policy);
+  ColorRGB32f shading(const Vector3r &position,
+                        const Vector3r &normal,
                         const std::vector<std::shared_ptr<LightSource>> &lights,
-                        const SurfaceColorSettings &colorSettings);
+                        const SurfaceColorSettings &colorSettings) const;
   std::shared_ptr<Scene> scene;
+  Camera camera;
+  std::shared_ptr<ThreadPool> threadPool;
+  int instructionSet;
+  RasterKernel::SpanFunction coverSpan;
+  bool visibilityBuffer;
+  bool backFaceCulling;
+  bool occlusionCulling;
+  bool levelOfDetail;
+  bool lightCulling;
+  bool verbose;
+  /// transformation from world space to homogeneous screen space, kept in double precision for culling and converted
+  /// per object for the vertex stage
   Matrix4d m;
-  std::map<std::shared_ptr<Vertex>, std::shared_ptr<Vector4d>> processedVertexPositions;
-  std::map<std::shared_ptr<Vertex>, std::shared_ptr<Vector3d>> dividedVertexPositions;
-  std::map<std::shared_ptr<Vertex>, std::shared_ptr<ColorRGB32f>> vertexColors;
-  std::map<std::shared_ptr<Face>, std::shared_ptr<ColorRGB32f>> faceColors;
-  std::map<std::pair<int, int>, std::shared_ptr<Fragment>> fragments;
-  std::map<std::pair<int, int>, double> zBuffer;
+  /// whether an object is rendered, indexed by the object index in the scene: 1 if it is, 0 if it is outside of the
+  /// view frustum and 2 if it is hidden behind the occluders
+  std::vector<char> visibleObjects;
+  /// level of detail rendered for every object, indexed by the object index in the scene. The vertex and face indices
+  /// of the processed objects and triangles refer to these meshes.
+  std::vector<const TriMesh *> objectMeshes;
+  /// depth of the occluders, and the pyramid built from it
+  std::vector<Real> occluderDepth;
+  DepthPyramid depthPyramid;
+  /// vertex stage results, indexed by the object index in the scene. Left unchanged for objects outside of the view.
+  std::vector<ProcessedObject> processedObjects;
+  /// whether the clip and screen space positions of an object are already computed for the current render, by the
+  /// depth pre-pass of the occluders, indexed by the object index in the scene
+  std::vector<char> projectedObjects;
+  ShadingConstants shadingConstants;
+  std::vector<RasterTriangle> triangles;
+  /// barycentric setups relative to the face of the triangles cut by the near plane
+  std::vector<EdgeSetup> attributeSetups;
+  RenderStats renderStats;
+  /// screen tiles in row-major order, allocated once per image size and reused between renders
+  std::vector<Tile> tiles;
+  int tileColumns;
+  std::pair<int, int> bufferSize;
   int shadingPolicy;
-  std::shared_ptr<Image32f> frameBuffer;
+  unsigned int shadingPolicyMask;
+  /// policies rendered by the current pass
+  unsigned int passPolicies;
+  /// policies with an up to date image
+  unsigned int renderedPolicies;
+  /// floating point and converted images, indexed by the shading policy
+  std::vector<std::shared_ptr<Image32f>> frameBuffers;
+  std::vector<std::shared_ptr<Image8i>> images;
 };
 
 #endif //PROG05_RENDERER_H
@@ -4,30 +4,48 @@
 
 #include <fstream>
 #include "Scene.h"
+#include "Utils.h"
+#include "Trace.h"
 
-Scene::Scene(const std::string &sceneFileName) : objects(), mainCamera(), lightSources() {
+Scene::Scene(const std::string &sceneFileName, const std::shared_ptr<ModelLibrary> &modelLibrary)
+    : objects(), mainCamera(), cameraPath(), lightSources() {
+  TRACE_SCOPE("Scene::Scene");
   std::string path = sceneFileName.substr(0, sceneFileName.find_last_of("/\\") + 1);
   std::ifstream ifs;
   ifs.open(sceneFileName.data(), std::ifstream::in);
+  auto models = modelLibrary ? modelLibrary : std::make_shared<ModelLibrary>();
+  // camera set by the e, l, u and f lines, the camera of the current keyframe after the first k line
+  Camera *camera = &mainCamera;
+  Camera keyframeCamera;
+  int keyframe = -1;
   std::string token;
   ifs >> token;
   while (ifs.good()) {
     if (token == "e") {
       double x, y, z;
       ifs >> x >> y >> z;
-      mainCamera.setEyePosition(Vector3d({x, y, z}));
+      camera->setEyePosition(Vector3d({x, y, z}));
     } else if (token == "l") {
       double x, y, z;
       ifs >> x >> y >> z;
-      mainCamera.setLookAtPosition(Vector3d({x, y, z}));
+      camera->setLookAtPosition(Vector3d({x, y, z}));
     } else if (token == "u") {
       double x, y, z;
       ifs >> x >> y >> z;
-      mainCamera.setUpDirection(Vector3d({x, y, z}));
+      camera->setUpDirection(Vector3d({x, y, z}));
     } else if (token == "f") {
       double angle;
       ifs >> angle;
-      mainCamera.setAngle(angle);
+      camera->setAngle(angle);
+    } else if (token == "k") {
+      // a keyframe starts from the camera of the previous one, or from the main camera
+      if (keyframe >= 0) {
+        cameraPath.addKeyframe(keyframe, keyframeCamera);
+      } else {
+        keyframeCamera = mainCamera;
+        camera = &keyframeCamera;
+      }
+      ifs >> keyframe;
     } else if (token == "i") {
       int width, height;
       ifs >> width >> height;
@@ -44,6 +62,13 @@ Scene::Scene(const std::string &sceneFileName) : objects(), mainCamera(), lightS
       ifs >> r >> g >> b;
       ColorRGB32f intensity({r, g, b});
       lightSources.push_back(std::make_shared<LightSource>(position, intensity));
+    } else if (token == "P") {
+      // point light reaching a limited distance
+      double x, y, z, radius;
+      ifs >> x >> y >> z;
+      float r, g, b;
+      ifs >> r >> g >> b >> radius;
+      lightSources.push_back(std::make_shared<LightSource>(Vector3d({x, y, z}), ColorRGB32f({r, g, b}), radius));
     } else if (token == "M") {
       std::string inputFileName;
       ifs >> inputFileName;
@@ -57,14 +82,39 @@ Scene::Scene(const std::string &sceneFileName) : objects(), mainCamera(), lightS
       ColorRGB32f colorSpecular({r, g, b});
       double phongExponent;
       ifs >> phongExponent;
-      objects.push_back(std::make_shared<Surface>(inputFileName,
+      // every file is loaded once, later objects instancing it share its model
+      objects.push_back(std::make_shared<Surface>(models->getModel(inputFileName),
                                                   colorAmbient,
                                                   colorDiffuse,
                                                   colorSpecular,
                                                   phongExponent));
+    } else if ((token == "t" || token == "r" || token == "s") && !objects.empty()) {
+      // transformations of the last object, applied in the order they are listed
+      double x, y, z;
+      Matrix4d transform;
+      if (token == "r") {
+        double angle;
+        ifs >> angle >> x >> y >> z;
+        transform = Utils::make3dRotateMatrix(angle, Vector3d({x, y, z}));
+      } else {
+        ifs >> x >> y >> z;
+        // the translation matrix moves points by the opposite of its argument
+        transform = token == "t" ? Utils::make3dTranslateMatrix(Vector3d({-x, -y, -z}))
+                                 : Utils::make3dScaleMatrix(Vector3d({x, y, z}));
+      }
+      objects.back()->setTransform(transform * objects.back()->getTransform());
     }
     ifs >> token;
   }
+  if (keyframe >= 0) {
+    cameraPath.addKeyframe(keyframe, keyframeCamera);
+  }
+  // every frame of the animation has the image size and depths of the main camera
+  for (auto &pathKeyframe: cameraPath.getKeyframes()) {
+    pathKeyframe.camera.setImageSize(mainCamera.getImageSize());
+    pathKeyframe.camera.setDepths(mainCamera.getDepths());
+  }
+  updateHierarchy();
 }
 
 const std::vector<std::shared_ptr<Surface>> &Scene::getObjects() const {
@@ -73,6 +123,21 @@ const std::vector<std::shared_ptr<Surface>> &Scene::getObjects() const {
 
 void Scene::setObjects(const std::vector<std::shared_ptr<Surface>> &objects) {
   Scene::objects = objects;
+  updateHierarchy();
+}
+
+const BoundingVolumeHierarchy &Scene::getHierarchy() const {
+  return hierarchy;
+}
+
+void Scene::updateHierarchy() {
+  std::vector<AxisAlignedBox> boxes;
+  std::vector<BoundingSphere> spheres;
+  for (const auto &object: objects) {
+    boxes.push_back(object->getBoundingBox());
+    spheres.push_back(object->getBoundingSphere());
+  }
+  hierarchy.build(boxes, spheres);
 }
 
 const Camera &Scene::getMainCamera() const {
@@ -83,6 +148,14 @@ void Scene::setMainCamera(const Camera &mainCamera) {
   Scene::mainCamera = mainCamera;
 }
 
+const CameraPath &Scene::getCameraPath() const {
+  return cameraPath;
+}
+
+void Scene::setCameraPath(const CameraPath &cameraPath) {
+  Scene::cameraPath = cameraPath;
+}
+
 const std::vector<std::shared_ptr<LightSource>> &Scene::getLightSources() const {
   return lightSources;
 }
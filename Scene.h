@@ -8,14 +8,17 @@
 #include <vector>
 #include "Surface.h"
 #include "Camera.h"
+#include "CameraPath.h"
 #include "LightSource.h"
+#include "BoundingVolumeHierarchy.h"
 
 /// Scene class
 class Scene {
  public:
   /// Read scene file and construct the scene
   /// \param sceneFileName input file name of the scene
-  explicit Scene(const std::string &sceneFileName);
+  /// \param modelLibrary models shared with other scenes, nullptr to only share the models within this scene
+  explicit Scene(const std::string &sceneFileName, const std::shared_ptr<ModelLibrary> &modelLibrary = nullptr);
 
   /// get the objects in the scene
   /// \return vector of pointers to the objects
@@ -25,6 +28,13 @@ class Scene {
   /// \param objects
   void setObjects(const std::vector<std::shared_ptr<Surface>> &objects);
 
+  /// get the bounding volume hierarchy over the objects, whose items are the object indices
+  /// \return
+  const BoundingVolumeHierarchy &getHierarchy() const;
+
+  /// rebuild the bounding volume hierarchy, needed after the bounds of an object changed
+  void updateHierarchy();
+
   /// get the camera in the scene
   /// \return reference to the camera object
   const Camera &getMainCamera() const;
@@ -33,6 +43,14 @@ class Scene {
   /// \param mainCamera
   void setMainCamera(const Camera &mainCamera);
 
+  /// get the camera path of the animation of the scene
+  /// \return the path given by the k lines of the scene file, empty for a still scene
+  const CameraPath &getCameraPath() const;
+
+  /// set the camera path of the animation of the scene
+  /// \param cameraPath
+  void setCameraPath(const CameraPath &cameraPath);
+
   /// get the light sources in the scene
   /// \return vector of pointers to the light sources
   const std::vector<std::shared_ptr<LightSource>> &getLightSources() const;
@@ -43,7 +61,9 @@ class Scene {
 
  private:
   std::vector<std::shared_ptr<Surface>> objects;
+  BoundingVolumeHierarchy hierarchy;
   Camera mainCamera;
+  CameraPath cameraPath;
   std::vector<std::shared_ptr<LightSource>> lightSources;
 };
 
@@ -0,0 +1,106 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "ShadingKernel.h"
+#include <algorithm>
+#include <cmath>
+
+void ShadingKernel::packConstants(const Scene &scene, const Vector3d &eye, ShadingConstants &constants) {
+  for (int k = 0; k < 3; k++) {
+    constants.eye[k] = static_cast<float>(eye(k));
+  }
+  const auto &lights = scene.getLightSources();
+  constants.lightX.resize(lights.size());
+  constants.lightY.resize(lights.size());
+  constants.lightZ.resize(lights.size());
+  constants.lightRed.resize(lights.size());
+  constants.lightGreen.resize(lights.size());
+  constants.lightBlue.resize(lights.size());
+  constants.lightInverseSquaredRadius.resize(lights.size());
+  for (unsigned long l = 0; l < lights.size(); l++) {
+    constants.lightX[l] = static_cast<float>(lights[l]->getPosition()(0));
+    constants.lightY[l] = static_cast<float>(lights[l]->getPosition()(1));
+    constants.lightZ[l] = static_cast<float>(lights[l]->getPosition()(2));
+    constants.lightRed[l] = lights[l]->getIntensity()(0);
+    constants.lightGreen[l] = lights[l]->getIntensity()(1);
+    constants.lightBlue[l] = lights[l]->getIntensity()(2);
+    double radius = lights[l]->getRadius();
+    constants.lightInverseSquaredRadius[l] = radius > 0. ? static_cast<float>(1. / (radius * radius)) : 0.f;
+  }
+  const auto &objects = scene.getObjects();
+  constants.materials.resize(objects.size());
+  for (unsigned long o = 0; o < objects.size(); o++) {
+    const SurfaceColorSettings &colorSettings = *objects[o]->getColorSettings();
+    PackedMaterial &material = constants.materials[o];
+    for (int k = 0; k < 3; k++) {
+      material.ambient[k] = colorSettings.kAmbient(k) * 0.5f;
+      material.diffuse[k] = colorSettings.kDiffuse(k);
+      material.specular[k] = colorSettings.kSpecular(k);
+    }
+    material.phongExponent = static_cast<float>(colorSettings.phongExponent);
+  }
+}
+
+void ShadingKernel::shadeBatch(const ShadingConstants &constants,
+                               const std::vector<unsigned int> &lights,
+                               int count,
+                               const float (&positions)[3][BATCH_SIZE],
+                               const float (&normals)[3][BATCH_SIZE],
+                               const unsigned int (&materials)[BATCH_SIZE],
+                               float (&colors)[3][BATCH_SIZE]) {
+  // gather the material of every lane, unused lanes repeat the first one
+  float diffuse[3][BATCH_SIZE], specular[3][BATCH_SIZE], exponent[BATCH_SIZE];
+  for (int lane = 0; lane < BATCH_SIZE; lane++) {
+    const PackedMaterial &material = constants.materials[materials[lane < count ? lane : 0]];
+    for (int k = 0; k < 3; k++) {
+      colors[k][lane] = material.ambient[k];
+      diffuse[k][lane] = material.diffuse[k];
+      specular[k][lane] = material.specular[k];
+    }
+    exponent[lane] = material.phongExponent;
+  }
+  // the camera direction does not depend on the light
+  float view[3][BATCH_SIZE];
+  for (int lane = 0; lane < BATCH_SIZE; lane++) {
+    float x = constants.eye[0] - positions[0][lane];
+    float y = constants.eye[1] - positions[1][lane];
+    float z = constants.eye[2] - positions[2][lane];
+    float inverseNorm = 1.f / std::sqrt(x * x + y * y + z * z);
+    view[0][lane] = x * inverseNorm;
+    view[1][lane] = y * inverseNorm;
+    view[2][lane] = z * inverseNorm;
+  }
+  for (auto l: lights) {
+    float diffuseAngle[BATCH_SIZE], specularAngle[BATCH_SIZE], attenuation[BATCH_SIZE];
+    for (int lane = 0; lane < BATCH_SIZE; lane++) {
+      float x = constants.lightX[l] - positions[0][lane];
+      float y = constants.lightY[l] - positions[1][lane];
+      float z = constants.lightZ[l] - positions[2][lane];
+      float squaredDistance = x * x + y * y + z * z;
+      // exactly 1 for the lights reaching everywhere, see LightSource::getAttenuation()
+      float window = std::max(1.f - squaredDistance * constants.lightInverseSquaredRadius[l], 0.f);
+      attenuation[lane] = window * window;
+      float inverseNorm = 1.f / std::sqrt(squaredDistance);
+      x *= inverseNorm;
+      y *= inverseNorm;
+      z *= inverseNorm;
+      diffuseAngle[lane] = normals[0][lane] * x + normals[1][lane] * y + normals[2][lane] * z;
+      float hx = x + view[0][lane];
+      float hy = y + view[1][lane];
+      float hz = z + view[2][lane];
+      inverseNorm = 1.f / std::sqrt(hx * hx + hy * hy + hz * hz);
+      specularAngle[lane] = (normals[0][lane] * hx + normals[1][lane] * hy + normals[2][lane] * hz) * inverseNorm;
+    }
+    for (int lane = 0; lane < BATCH_SIZE; lane++) {
+      specularAngle[lane] = std::pow(specularAngle[lane], exponent[lane]);
+    }
+    const float intensity[3] = {constants.lightRed[l], constants.lightGreen[l], constants.lightBlue[l]};
+    for (int k = 0; k < 3; k++) {
+      for (int lane = 0; lane < BATCH_SIZE; lane++) {
+        colors[k][lane] += intensity[k] * attenuation[lane] * (diffuse[k][lane] * diffuseAngle[lane]
+            + specular[k][lane] * specularAngle[lane]);
+      }
+    }
+  }
+}
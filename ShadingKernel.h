@@ -0,0 +1,57 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_SHADINGKERNEL_H
+#define PROG05_SHADINGKERNEL_H
+
+#include "Scene.h"
+
+/// Color settings of a surface, packed for batched shading
+struct PackedMaterial {
+  /// ambient color already multiplied by the ambient light
+  float ambient[3];
+  float diffuse[3];
+  float specular[3];
+  float phongExponent;
+};
+
+/// Per-frame constants of the batched shading kernel, hoisted out of the per-fragment loop
+struct ShadingConstants {
+  float eye[3];
+  std::vector<float> lightX, lightY, lightZ;
+  std::vector<float> lightRed, lightGreen, lightBlue;
+  /// 1 / radius^2 of the lights, 0 for the lights reaching everywhere
+  std::vector<float> lightInverseSquaredRadius;
+  /// materials indexed by the object index in the scene
+  std::vector<PackedMaterial> materials;
+};
+
+/// Blinn-Phong shading of fragment batches stored as structure of arrays
+class ShadingKernel {
+ public:
+  /// number of fragments shaded together
+  static const int BATCH_SIZE = 8;
+  /// pack the camera, lights and materials of a scene
+  /// \param scene
+  /// \param eye eye position of the camera rendering the frame
+  /// \param constants resulted per-frame constants
+  static void packConstants(const Scene &scene, const Vector3d &eye, ShadingConstants &constants);
+  /// shade a batch of fragments. Lanes past count are ignored.
+  /// \param constants per-frame constants
+  /// \param lights indices of the lights reaching the fragments, in the order of the lights of the scene
+  /// \param count number of valid lanes, at most BATCH_SIZE
+  /// \param positions world space positions, one plane per axis of BATCH_SIZE lanes each
+  /// \param normals unit normals, one plane per axis of BATCH_SIZE lanes each
+  /// \param materials material index of each lane
+  /// \param colors resulted colors, one plane per channel of BATCH_SIZE lanes each
+  static void shadeBatch(const ShadingConstants &constants,
+                         const std::vector<unsigned int> &lights,
+                         int count,
+                         const float (&positions)[3][BATCH_SIZE],
+                         const float (&normals)[3][BATCH_SIZE],
+                         const unsigned int (&materials)[BATCH_SIZE],
+                         float (&colors)[3][BATCH_SIZE]);
+};
+
+#endif //PROG05_SHADINGKERNEL_H
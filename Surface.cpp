@@ -3,15 +3,88 @@
 //
 
 #include "Surface.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
 Surface::Surface(const std::string &inputFileName,
                  const ColorRGB32f &kAmbient,
                  const ColorRGB32f &kDiffuse,
                  const ColorRGB32f &kSpecular,
                  double phongExponent)
-    : mesh(inputFileName), colorSettings(std::make_shared<SurfaceColorSettings>(kAmbient, kDiffuse, kSpecular, phongExponent)) {
+    : Surface(std::make_shared<const Model>(inputFileName), kAmbient, kDiffuse, kSpecular, phongExponent) {
+}
+Surface::Surface(const std::shared_ptr<const Model> &model,
+                 const ColorRGB32f &kAmbient,
+                 const ColorRGB32f &kDiffuse,
+                 const ColorRGB32f &kSpecular,
+                 double phongExponent)
+    : model(model), transformed(false), boundingBox(model->getBoundingBox()),
+      boundingSphere(model->getBoundingSphere()),
+      colorSettings(std::make_shared<SurfaceColorSettings>(kAmbient, kDiffuse, kSpecular, phongExponent)) {
+  transform = Matrix4d(0.);
+  normalTransform = Matrix3d(0.);
+  for (int i = 0; i < 4; i++) {
+    transform(i, i) = 1.;
+    if (i < 3) {
+      normalTransform(i, i) = 1.;
+    }
+  }
+}
+const Model &Surface::getModel() const {
+  return *model;
 }
 const TriMesh &Surface::getMesh() const {
-  return mesh;
+  return model->getMesh();
+}
+const Matrix4d &Surface::getTransform() const {
+  return transform;
+}
+const Matrix3d &Surface::getNormalTransform() const {
+  return normalTransform;
+}
+bool Surface::hasTransform() const {
+  return transformed;
+}
+void Surface::setTransform(const Matrix4d &transform) {
+  Surface::transform = transform;
+  normalTransform = Utils::makeNormalMatrix(transform);
+  transformed = true;
+  // the box around the transformed corners
+  const AxisAlignedBox &box = model->getBoundingBox();
+  boundingBox = AxisAlignedBox();
+  boundingSphere = BoundingSphere();
+  if (box.isEmpty()) {
+    return;
+  }
+  for (int corner = 0; corner < 8; corner++) {
+    Vector3d point({corner & 1 ? box.max(0) : box.min(0),
+                    corner & 2 ? box.max(1) : box.min(1),
+                    corner & 4 ? box.max(2) : box.min(2)});
+    boundingBox.extend(Utils::homoDivideVector4d(transform * Utils::make4dHomoCoordPoint(point)));
+  }
+  // the largest stretch of the linear part is bounded by its Frobenius norm and by the root of the product of its
+  // largest absolute column and row sums
+  const BoundingSphere &sphere = model->getBoundingSphere();
+  double squaredNorm = 0., columnSum = 0., rowSum = 0.;
+  for (int i = 0; i < 3; i++) {
+    double column = 0., row = 0.;
+    for (int j = 0; j < 3; j++) {
+      squaredNorm += transform(i, j) * transform(i, j);
+      column += std::abs(transform(j, i));
+      row += std::abs(transform(i, j));
+    }
+    columnSum = std::max(columnSum, column);
+    rowSum = std::max(rowSum, row);
+  }
+  double stretch = std::min(squaredNorm, columnSum * rowSum);
+  boundingSphere.center = Utils::homoDivideVector4d(transform * Utils::make4dHomoCoordPoint(sphere.center));
+  boundingSphere.radius = sphere.radius * std::sqrt(stretch);
+}
+const AxisAlignedBox &Surface::getBoundingBox() const {
+  return boundingBox;
+}
+const BoundingSphere &Surface::getBoundingSphere() const {
+  return boundingSphere;
 }
 const std::shared_ptr<SurfaceColorSettings> &Surface::getColorSettings() const {
   return colorSettings;
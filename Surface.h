@@ -5,7 +5,9 @@
 #ifndef PROG05_SURFACE_H
 #define PROG05_SURFACE_H
 
-#include "TriMesh.h"
+#include <memory>
+#include <string>
+#include "Model.h"
 #include "Color.h"
 /// Color settings of a surface
 struct SurfaceColorSettings {
@@ -16,10 +18,10 @@ struct SurfaceColorSettings {
   ColorRGB32f kAmbient, kDiffuse, kSpecular;
   double phongExponent;
 };
-/// Surface class
+/// Instance of a model in the scene, with its own placement and material
 class Surface {
  public:
-  /// Read a mesh file and construct a surface object
+  /// Read a mesh file and construct a surface object with a model of its own
   /// \param inputFileName input mesh file name
   /// \param kAmbient ambient parameter
   /// \param kDiffuse diffuse parameter
@@ -30,9 +32,42 @@ class Surface {
           const ColorRGB32f &kDiffuse,
           const ColorRGB32f &kSpecular,
           double phongExponent);
-  /// get the trigonal mesh
+  /// Construct a surface object instancing a model shared with other surfaces
+  /// \param model
+  /// \param kAmbient ambient parameter
+  /// \param kDiffuse diffuse parameter
+  /// \param kSpecular specular parameter
+  /// \param phongExponent phone exponent
+  Surface(const std::shared_ptr<const Model> &model,
+          const ColorRGB32f &kAmbient,
+          const ColorRGB32f &kDiffuse,
+          const ColorRGB32f &kSpecular,
+          double phongExponent);
+  /// get the instanced model
+  /// \return
+  const Model &getModel() const;
+  /// get the trigonal mesh, in model space
   /// \return reference to the trigonal mesh
   const TriMesh &getMesh() const;
+  /// get the transformation from model space to world space
+  /// \return
+  const Matrix4d &getTransform() const;
+  /// get the matrix transforming the normals from model space to world space, see Utils::makeNormalMatrix()
+  /// \return
+  const Matrix3d &getNormalTransform() const;
+  /// whether a transformation has been set. Model space is world space otherwise.
+  /// \return
+  bool hasTransform() const;
+  /// set the transformation from model space to world space. The hierarchy of the scene needs to be updated after
+  /// changing the transformation of one of its objects.
+  /// \param transform affine transformation
+  void setTransform(const Matrix4d &transform);
+  /// get the bounding box of the surface in world space, enclosing all levels of detail
+  /// \return
+  const AxisAlignedBox &getBoundingBox() const;
+  /// get the bounding sphere of the surface in world space, enclosing all levels of detail
+  /// \return
+  const BoundingSphere &getBoundingSphere() const;
   /// get the color parameters
   /// \return pointer the parameter struct
   const std::shared_ptr<SurfaceColorSettings> &getColorSettings() const;
@@ -40,7 +75,12 @@ class Surface {
   /// \param colorSettings
   void setColorSettings(const std::shared_ptr<SurfaceColorSettings> &colorSettings);
  private:
-  TriMesh mesh;
+  std::shared_ptr<const Model> model;
+  Matrix4d transform;
+  Matrix3d normalTransform;
+  bool transformed;
+  AxisAlignedBox boundingBox;
+  BoundingSphere boundingSphere;
   std::shared_ptr<SurfaceColorSettings> colorSettings;
 };
 
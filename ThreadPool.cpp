@@ -0,0 +1,90 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadNumber)
+    : currentTask(nullptr), currentTaskNumber(0), nextTask(0), generation(0), busyWorkers(0), stopping(false) {
+  if (threadNumber == 0) {
+    threadNumber = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned int i = 1; i < threadNumber; i++) {
+    workers.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeCondition.notify_all();
+  for (auto &worker: workers) {
+    worker.join();
+  }
+}
+unsigned int ThreadPool::getThreadNumber() const {
+  return static_cast<unsigned int>(workers.size() + 1);
+}
+void ThreadPool::parallelFor(unsigned long taskNumber, const std::function<void(unsigned long)> &task) {
+  if (taskNumber == 0) {
+    return;
+  }
+  if (workers.empty() || taskNumber == 1) {
+    for (unsigned long i = 0; i < taskNumber; i++) {
+      task(i);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentTask = &task;
+    currentTaskNumber = taskNumber;
+    nextTask = 0;
+    taskException = nullptr;
+    busyWorkers = static_cast<unsigned int>(workers.size());
+    generation++;
+  }
+  wakeCondition.notify_all();
+  runTasks();
+  std::unique_lock<std::mutex> lock(mutex);
+  doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+  currentTask = nullptr;
+  if (taskException) {
+    std::rethrow_exception(taskException);
+  }
+}
+void ThreadPool::workerLoop() {
+  Trace::setThreadName("ThreadPool worker");
+  unsigned long seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+    }
+    runTasks();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--busyWorkers == 0) {
+      doneCondition.notify_one();
+    }
+  }
+}
+void ThreadPool::runTasks() {
+  for (unsigned long i = nextTask++; i < currentTaskNumber; i = nextTask++) {
+    try {
+      TRACE_SCOPE("ThreadPool task");
+      (*currentTask)(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!taskException) {
+        taskException = std::current_exception();
+      }
+    }
+  }
+}
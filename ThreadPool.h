@@ -0,0 +1,50 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_THREADPOOL_H
+#define PROG05_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fixed size pool of worker threads running data parallel loops
+class ThreadPool {
+ public:
+  /// Construct the pool
+  /// \param threadNumber number of threads running a loop, including the calling thread. 0 uses all hardware threads.
+  explicit ThreadPool(unsigned int threadNumber);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+  /// get the number of threads running a loop, including the calling thread
+  /// \return
+  unsigned int getThreadNumber() const;
+  /// run task(i) for every i in [0, taskNumber) and return when all of them finished. Tasks are picked up in
+  /// increasing order by the workers and the calling thread. The first exception thrown by a task is rethrown here.
+  /// Not reentrant: tasks must not call parallelFor on the same pool.
+  /// \param taskNumber
+  /// \param task
+  void parallelFor(unsigned long taskNumber, const std::function<void(unsigned long)> &task);
+ private:
+  void workerLoop();
+  void runTasks();
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wakeCondition;
+  std::condition_variable doneCondition;
+  const std::function<void(unsigned long)> *currentTask;
+  unsigned long currentTaskNumber;
+  std::atomic<unsigned long> nextTask;
+  unsigned long generation;
+  unsigned int busyWorkers;
+  std::exception_ptr taskException;
+  bool stopping;
+};
+
+#endif //PROG05_THREADPOOL_H
@@ -0,0 +1,136 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+struct TraceEvent {
+  const char *name;
+  Trace::Clock::time_point begin, end;
+};
+
+/// ring buffer of the scopes of one thread, kept after the thread exits
+struct ThreadBuffer {
+  unsigned int threadIndex;
+  const char *threadName = nullptr;
+  std::vector<TraceEvent> events;
+  /// number of scopes recorded since the last clear, the ring holds the last RING_SIZE of them
+  std::atomic<unsigned long> recorded{0};
+};
+
+std::atomic<bool> traceEnabled(false);
+std::mutex registryMutex;
+
+std::vector<std::shared_ptr<ThreadBuffer>> &getRegistry() {
+  static std::vector<std::shared_ptr<ThreadBuffer>> registry;
+  return registry;
+}
+
+Trace::Clock::time_point getEpoch() {
+  static const Trace::Clock::time_point epoch = Trace::Clock::now();
+  return epoch;
+}
+
+/// buffer of the calling thread, allocated when it records its first scope
+thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+thread_local const char *threadName = nullptr;
+
+ThreadBuffer &getThreadBuffer() {
+  if (!threadBuffer) {
+    threadBuffer = std::make_shared<ThreadBuffer>();
+    threadBuffer->threadName = threadName;
+    threadBuffer->events.resize(Trace::RING_SIZE);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    threadBuffer->threadIndex = static_cast<unsigned int>(getRegistry().size());
+    getRegistry().push_back(threadBuffer);
+  }
+  return *threadBuffer;
+}
+
+/// escape a string for JSON
+std::string quote(const char *value) {
+  std::string quoted = "\"";
+  for (; *value; value++) {
+    if (*value == '"' || *value == '\\') {
+      quoted += '\\';
+    }
+    quoted += *value;
+  }
+  return quoted + "\"";
+}
+}
+
+// std::min takes the ring size by reference, which needs a definition
+const unsigned long Trace::RING_SIZE;
+
+bool Trace::isCompiledIn() {
+#ifdef RASTERIZER_TRACE
+  return true;
+#else
+  return false;
+#endif
+}
+bool Trace::isEnabled() {
+  return traceEnabled.load(std::memory_order_relaxed);
+}
+void Trace::setEnabled(bool enabled) {
+  getEpoch();
+  traceEnabled = enabled;
+}
+void Trace::setThreadName(const char *name) {
+  threadName = name;
+  if (threadBuffer) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    threadBuffer->threadName = name;
+  }
+}
+void Trace::record(const char *name, Clock::time_point begin, Clock::time_point end) {
+  ThreadBuffer &buffer = getThreadBuffer();
+  auto index = buffer.recorded.load(std::memory_order_relaxed);
+  buffer.events[index % RING_SIZE] = TraceEvent{name, begin, end};
+  buffer.recorded.store(index + 1, std::memory_order_release);
+}
+bool Trace::writeChromeTrace(const std::string &fileName) {
+  std::ofstream out(fileName);
+  if (!out) {
+    return false;
+  }
+  auto epoch = getEpoch();
+  auto getMicroseconds = [epoch](Clock::time_point time) {
+    return std::chrono::duration<double, std::micro>(time - epoch).count();
+  };
+  out.precision(3);
+  out << std::fixed << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  const char *separator = "";
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const auto &buffer: getRegistry()) {
+    if (buffer->threadName) {
+      out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadIndex
+          << ", \"args\": {\"name\": " << quote(buffer->threadName) << "}}";
+      separator = ",\n";
+    }
+    auto recorded = buffer->recorded.load(std::memory_order_acquire);
+    for (auto i = recorded - std::min(recorded, RING_SIZE); i < recorded; i++) {
+      const TraceEvent &event = buffer->events[i % RING_SIZE];
+      out << separator << "{\"name\": " << quote(event.name) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+          << buffer->threadIndex << ", \"ts\": " << getMicroseconds(event.begin) << ", \"dur\": "
+          << getMicroseconds(event.end) - getMicroseconds(event.begin) << "}";
+      separator = ",\n";
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+void Trace::clear() {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const auto &buffer: getRegistry()) {
+    buffer->recorded = 0;
+  }
+}
@@ -0,0 +1,78 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+
+#ifndef PROG05_TRACE_H
+#define PROG05_TRACE_H
+
+#include <chrono>
+#include <string>
+
+/// Timeline of scoped timers, written as a Chrome trace that opens in chrome://tracing or Perfetto.
+///
+/// Every thread records its scopes into a ring buffer of its own, so recording takes no lock, and the oldest scopes
+/// of a thread are dropped once RING_SIZE scopes are recorded. The scopes of TRACE_SCOPE are only compiled in when
+/// RASTERIZER_TRACE is defined (the RASTERIZER_TRACE CMake option), and only recorded while tracing is enabled.
+class Trace {
+ public:
+  using Clock = std::chrono::steady_clock;
+  /// number of scopes kept per thread
+  static const unsigned long RING_SIZE = 1ul << 16;
+  /// whether the scopes of TRACE_SCOPE are compiled in
+  /// \return
+  static bool isCompiledIn();
+  /// whether scopes are recorded
+  /// \return
+  static bool isEnabled();
+  /// start or stop recording scopes, stopped by default
+  /// \param enabled
+  static void setEnabled(bool enabled);
+  /// name the calling thread in the trace
+  /// \param name string literal
+  static void setThreadName(const char *name);
+  /// record a scope of the calling thread
+  /// \param name string literal
+  /// \param begin
+  /// \param end
+  static void record(const char *name, Clock::time_point begin, Clock::time_point end);
+  /// write the scopes recorded by every thread as a Chrome trace, in microseconds since the first use of the trace.
+  /// Must not be called while other threads record scopes.
+  /// \param fileName
+  /// \return false if the file cannot be written
+  static bool writeChromeTrace(const std::string &fileName);
+  /// drop the scopes recorded so far. Must not be called while other threads record scopes.
+  static void clear();
+};
+
+/// Records the time between its construction and its destruction while tracing is enabled
+class TraceScope {
+ public:
+  /// \param name string literal
+  explicit TraceScope(const char *name) : name(Trace::isEnabled() ? name : nullptr) {
+    if (this->name) {
+      begin = Trace::Clock::now();
+    }
+  }
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+  ~TraceScope() {
+    if (name) {
+      Trace::record(name, begin, Trace::Clock::now());
+    }
+  }
+ private:
+  const char *name;
+  Trace::Clock::time_point begin;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#ifdef RASTERIZER_TRACE
+/// time the rest of the enclosing block in the trace
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+// the name is still evaluated, so that names only used for tracing are not unused
+#define TRACE_SCOPE(name) static_cast<void>(name)
+#endif
+
+#endif //PROG05_TRACE_H
@@ -3,227 +3,240 @@
 //
 
 #include "TriMesh.h"
-#include <fstream>
-#include <sstream>
-
-TriMesh::TriMesh(std::string inputFileName) : halfEdgeMeshInitialized(false), normalUpdated(false) {
-  std::ifstream fin(inputFileName);
-  char c;
-  fin.get(c);
-  while (fin.good()) {
-    double x, y, z;
-    int v[3];
-    switch (c) {
-      case '#':fin.ignore(256, '\n');
-        fin.get(c);
-        break;
-      case 'v':fin >> x >> y >> z;
-        vertices.push_back(std::make_shared<Vertex>(x, y, z));
-        vertices[vertices.size() - 1]->index = static_cast<int>(vertices.size() - 1);
-        fin.get(c);
-        break;
-      case 'f':fin >> v[0] >> v[1] >> v[2];
-        faceIndices.emplace_back(std::initializer_list<int>{v[0] - 1, v[1] - 1, v[2] - 1});
-        fin.get(c);
-        break;
-      default:fin.get(c);
-        break;
+#include "MeshIO.h"
+#include "MeshCache.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+TriMesh::TriMesh(std::string inputFileName, unsigned int threadNumber)
+    : subdivisionLevel(0), threadNumber(threadNumber), halfEdgeMeshInitialized(false), vertexNormalsLoaded(false) {
+  TRACE_SCOPE("TriMesh::TriMesh");
+  MeshData data;
+  bool cached = MeshCache::read(inputFileName, data, adjacency);
+  if (!cached) {
+    std::string error;
+    if (!MeshIO::readObjFile(inputFileName, data, error, threadNumber)) {
+      throw std::runtime_error(error);
+    }
+    for (auto &normal: data.normals) {
+      normal = normal.normalize();
     }
   }
+  vertexNormalsLoaded = !data.normals.empty();
+  positionBuffer = castBuffer<Real>(std::move(data.positions));
+  normalBuffer = castBuffer<Real>(std::move(data.normals));
+  faceIndices = std::move(data.faces);
+  initializeHalfEdgeMesh();
+  if (!cached) {
+    data.positions = castBuffer<double>(std::vector<Vector3r>(positionBuffer));
+    data.normals = castBuffer<double>(std::vector<Vector3r>(normalBuffer));
+    data.faces = faceIndices;
+    MeshCache::write(inputFileName, data, adjacency);
+  }
+  if (adjacency.nonManifoldEdgeNumber > 0) {
+    std::cerr << inputFileName << ": " << adjacency.nonManifoldEdgeNumber << " non-manifold edges" << std::endl;
+  }
+}
+
+TriMesh::TriMesh(MeshData &&data, HalfEdgeAdjacency &&adjacency, unsigned int threadNumber)
+    : adjacency(std::move(adjacency)), subdivisionLevel(0), threadNumber(threadNumber),
+      halfEdgeMeshInitialized(false), vertexNormalsLoaded(!data.normals.empty()) {
+  TRACE_SCOPE("TriMesh::TriMesh");
+  positionBuffer = castBuffer<Real>(std::move(data.positions));
+  normalBuffer = castBuffer<Real>(std::move(data.normals));
+  faceIndices = std::move(data.faces);
   initializeHalfEdgeMesh();
-  fin.close();
 }
 
 bool TriMesh::writeToObjFile(std::string outputFileName) {
-  std::ofstream fout(outputFileName);
-  fout.precision(10);
-  for (auto &vertex: vertices) {
-    fout << "v " << vertex->position->operator()(0) << " " << vertex->position->operator()(1) << " "
-         << vertex->position->operator()(2) << std::endl;
-  }
-  for (auto &face: faceIndices) {
-    fout << "f " << face(0) + 1 << " " << face(1) + 1 << " " << face(2) + 1 << std::endl;
-  }
-  fout.close();
-  return true;
+  return MeshIO::writeObjFile(outputFileName, castBuffer<double>(std::vector<Vector3r>(positionBuffer)), faceIndices);
 }
 
 void TriMesh::initializeHalfEdgeMesh() {
   if (halfEdgeMeshInitialized) {
     return;
   }
-  halfEdges.clear();
-  faces.clear();
-  for (int t = 0; t < faceIndices.size(); t++) {
-    faces.push_back(std::make_shared<Face>());
-    for (int i = 0; i < 3; i++) {
-      halfEdges[getEdgePair(faceIndices[t], i)] = std::make_shared<HalfEdge>();
+  if (adjacency.opposites.size() != faceIndices.size() * 3) {
+    MeshTopology::pairHalfEdges(faceIndices, adjacency, threadNumber);
+  }
+  if (vertexHalfEdges.size() != positionBuffer.size()) {
+    MeshTopology::findVertexHalfEdges(faceIndices, positionBuffer.size(), vertexHalfEdges);
+  }
+  indexBuffer.resize(faceIndices.size() * 3);
+  for (int f = 0; f < static_cast<int>(faceIndices.size()); f++) {
+    uint32_t *index = &indexBuffer[f * 3];
+    for (int32_t halfEdge: getFaceLoop(f)) {
+      *index++ = static_cast<uint32_t>(getStartVertex(halfEdge));
     }
-    for (int i = 0; i < 3; i++) {
-      auto e = getEdgePair(faceIndices[t], i);
-      auto halfEdge = halfEdges[e];
-      halfEdge->face = faces[t];
-      faces[t]->halfEdge = halfEdge;
-      halfEdge->startVertex = vertices[e.first];
-      vertices[e.first]->halfEdge = halfEdge;
-      halfEdge->nextHalfEdge = halfEdges[getEdgePair(faceIndices[t], i + 1)];
-      auto oe = getOppositeEdgePair(e);
-      if (halfEdges.find(oe) != halfEdges.end()) {
-        halfEdge->oppositeHalfEdge = halfEdges[oe];
-        halfEdges[oe]->oppositeHalfEdge = halfEdge;
-      }
+  }
+  boundingBox = AxisAlignedBox();
+  for (const auto &position: positionBuffer) {
+    boundingBox.extend(position.cast<double>());
+  }
+  boundingSphere = BoundingSphere();
+  if (!boundingBox.isEmpty()) {
+    boundingSphere.center = boundingBox.getCenter();
+    double squaredRadius = 0.;
+    for (const auto &position: positionBuffer) {
+      Vector3d offset = position.cast<double>() - boundingSphere.center;
+      squaredRadius = std::max(squaredRadius, offset.dot(offset));
     }
+    boundingSphere.radius = std::sqrt(squaredRadius);
   }
   halfEdgeMeshInitialized = true;
   updateNormals();
 }
 
-std::pair<int, int> TriMesh::getEdgePair(const Vector3i &face, int i) {
-  int u = face(i % 3);
-  int v = face((i + 1) % 3);
-  return std::make_pair(u, v);
+void TriMesh::subdivision(unsigned int levels) {
+  setSubdivisionLevel(subdivisionLevel + levels);
 }
 
-std::pair<int, int> TriMesh::getOppositeEdgePair(std::pair<int, int> e) {
-  return {e.second, e.first};
-}
-
-void TriMesh::subdivision() {
+void TriMesh::setSubdivisionLevel(unsigned int level) {
+  TRACE_SCOPE("TriMesh::setSubdivisionLevel");
   initializeHalfEdgeMesh();
-  std::vector<Vector3i> newFaceIndices;
-  std::map<std::shared_ptr<HalfEdge>, int> newVertexIndices;
-  auto oldVertexNumber = static_cast<int>(vertices.size());
-  for (auto &face: faces) {
-    auto halfEdge = face->halfEdge;
-    do {
-      auto u = halfEdge->startVertex;
-      auto v = halfEdge->nextHalfEdge->startVertex;
-      if (newVertexIndices.find(halfEdge) == newVertexIndices.end()) {
-        auto w = halfEdge->nextHalfEdge->nextHalfEdge->startVertex;
-        auto x = halfEdge->oppositeHalfEdge->nextHalfEdge->nextHalfEdge->startVertex;
-        Vector3d newPosition =
-            (*(u->position)) * 3. / 8. + (*(v->position)) * 3. / 8. + (*(w->position)) / 8.
-                + (*(x->position)) / 8.;
-        vertices.push_back(std::make_shared<Vertex>(newPosition));
-        vertices[vertices.size() - 1]->index = static_cast<int>(vertices.size() - 1);
-        newVertexIndices[halfEdge] = newVertexIndices[halfEdge->oppositeHalfEdge] =
-            static_cast<int>(vertices.size() -
-                1);
-      }
-      halfEdge = halfEdge->nextHalfEdge;
-    } while (halfEdge != face->halfEdge);
-    do {
-      newFaceIndices.emplace_back(
-          std::initializer_list<int>{newVertexIndices[halfEdge],
-                                     halfEdge->nextHalfEdge->startVertex->index,
-                                     newVertexIndices[halfEdge->nextHalfEdge]});
-      halfEdge = halfEdge->nextHalfEdge;
-    } while (halfEdge != face->halfEdge);
-    newFaceIndices.emplace_back(
-        std::initializer_list<int>{newVertexIndices[halfEdge],
-                                   newVertexIndices[halfEdge->nextHalfEdge],
-                                   newVertexIndices[halfEdge->nextHalfEdge->nextHalfEdge]});
+  if (level == subdivisionLevel) {
+    return;
   }
-  faceIndices = newFaceIndices;
-  halfEdgeMeshInitialized = false;
-  normalUpdated = false;
-  std::vector<Vector3d> newPositions;
-//  initializeHalfEdgeMesh();
-  for (int i = 0; i < oldVertexNumber; i++) {
-    auto neighbors = getVertexVertices(vertices[i]);
-    double beta = 3. / (8. * neighbors.size());
-    if (neighbors.size() == 3) {
-      beta = 3. / 16.;
-    }
-    newPositions.emplace_back(vertices[i]->position->operator*(1 - neighbors.size() * beta));
-    for (const auto &neighbor: neighbors) {
-      newPositions[i] += neighbor->position->operator*(beta);
+  if (subdivisionLevels.empty()) {
+    subdivisionLevels.emplace_back();
+    auto &base = subdivisionLevels[0];
+    base.positions = castBuffer<double>(std::vector<Vector3r>(positionBuffer));
+    base.faces = faceIndices;
+    base.adjacency = adjacency;
+    base.vertexHalfEdges = vertexHalfEdges;
+    if (vertexNormalsLoaded) {
+      baseNormals = normalBuffer;
     }
   }
-  for (int i = 0; i < oldVertexNumber; i++) {
-    *vertices[i]->position = newPositions[i];
+  if (level >= subdivisionLevels.size()) {
+    std::vector<SubdivisionLevel> newLevels;
+    LoopSubdivision::subdivide(subdivisionLevels.back(),
+                               static_cast<unsigned int>(level + 1 - subdivisionLevels.size()),
+                               newLevels, threadNumber);
+    for (auto &newLevel: newLevels) {
+      subdivisionLevels.push_back(std::move(newLevel));
+    }
   }
+  const auto &mesh = subdivisionLevels[level];
+  vertexNormalsLoaded = level == 0 && !baseNormals.empty();
+  positionBuffer = castBuffer<Real>(std::vector<Vector3d>(mesh.positions));
+  normalBuffer = vertexNormalsLoaded ? baseNormals : std::vector<Vector3r>();
+  faceIndices = mesh.faces;
+  adjacency = mesh.adjacency;
+  vertexHalfEdges = mesh.vertexHalfEdges;
+  subdivisionLevel = level;
+  halfEdgeMeshInitialized = false;
+  initializeHalfEdgeMesh();
+}
+
+unsigned int TriMesh::getSubdivisionLevel() const {
+  return subdivisionLevel;
 }
 
 int TriMesh::getVertexNumber() {
-  return static_cast<int>(vertices.size());
+  return static_cast<int>(positionBuffer.size());
 }
 
 int TriMesh::getFaceNumber() {
-  return static_cast<int>(faces.size());
+  return static_cast<int>(faceIndices.size());
+}
+
+unsigned long TriMesh::getBoundaryEdgeNumber() const {
+  return adjacency.boundaryEdgeNumber;
 }
 
-std::vector<std::shared_ptr<Vertex>> TriMesh::getVertexVertices(const std::shared_ptr<Vertex> &v) {
-  std::vector<std::shared_ptr<Vertex>> neighbors;
-  auto halfEdge = v->halfEdge;
-  do {
-    neighbors.push_back(halfEdge->nextHalfEdge->startVertex);
-    halfEdge = halfEdge->nextHalfEdge->nextHalfEdge->oppositeHalfEdge;
-  } while (halfEdge != v->halfEdge);
-  return neighbors;
+unsigned long TriMesh::getNonManifoldEdgeNumber() const {
+  return adjacency.nonManifoldEdgeNumber;
 }
+
 void TriMesh::updateNormals() {
   if (!halfEdgeMeshInitialized) {
     initializeHalfEdgeMesh();
-  }
-  if (normalUpdated) {
     return;
   }
-  for (auto &face: faces) {
-    auto vertices = getFaceVertices(face);
-    Vector3d ab = (*(vertices[1]->position)) - (*(vertices[0]->position));
-    Vector3d ac = (*(vertices[2]->position)) - (*(vertices[0]->position));
-    face->normal = std::make_shared<Vector3d>(ab.cross(ac).normalize());
-    Vector3d position(0.);
+  faceNormalBuffer.resize(faceIndices.size());
+  facePositionBuffer.resize(faceIndices.size());
+  for (int f = 0; f < static_cast<int>(faceIndices.size()); f++) {
+    const Vector3r *vertices[3];
+    const Vector3r **vertex = vertices;
+    for (int32_t halfEdge: getFaceLoop(f)) {
+      *vertex++ = &positionBuffer[getStartVertex(halfEdge)];
+    }
+    Vector3r ab = *vertices[1] - *vertices[0];
+    Vector3r ac = *vertices[2] - *vertices[0];
+    faceNormalBuffer[f] = ab.cross(ac).normalize();
+    Vector3r position(0);
     for (int i = 0; i < 3; i++) {
-      position += *vertices[i]->position;
+      position += *vertices[i];
     }
     position /= 3;
-    face->position = std::make_shared<Vector3d>(position);
+    facePositionBuffer[f] = position;
   }
-  for (auto &vertex: vertices) {
-    auto faceNeighbors = getVertexFaces(vertex);
-    Vector3d normalSum(0);
-    for (auto &face: faceNeighbors) {
-      normalSum += *face->normal;
+  if (!vertexNormalsLoaded) {
+    normalBuffer.resize(positionBuffer.size());
+    for (int v = 0; v < static_cast<int>(positionBuffer.size()); v++) {
+      Vector3r normalSum(0);
+      for (int32_t halfEdge: getVertexRing(v)) {
+        normalSum += faceNormalBuffer[getHalfEdgeFace(halfEdge)];
+      }
+      normalBuffer[v] = normalSum.normalize();
     }
-    vertex->normal = std::make_shared<Vector3d>(normalSum.normalize());
   }
-  normalUpdated = true;
 }
-std::vector<std::shared_ptr<Vertex>> TriMesh::getFaceVertices(std::shared_ptr<Face> face) const {
-  std::vector<std::shared_ptr<Vertex>> res;
-  res.push_back(face->halfEdge->startVertex);
-  res.push_back(face->halfEdge->nextHalfEdge->startVertex);
-  res.push_back(face->halfEdge->nextHalfEdge->nextHalfEdge->startVertex);
-  return res;
+
+VertexRing TriMesh::getVertexRing(int vertex) const {
+  return {adjacency.opposites, vertexHalfEdges[vertex]};
+}
+
+FaceLoop TriMesh::getFaceLoop(int face) const {
+  return FaceLoop(face);
+}
+
+int TriMesh::getStartVertex(int32_t halfEdge) const {
+  return MeshTopology::getStartVertex(faceIndices, halfEdge);
+}
+
+int TriMesh::getEndVertex(int32_t halfEdge) const {
+  return MeshTopology::getEndVertex(faceIndices, halfEdge);
 }
-std::vector<std::shared_ptr<Face>> TriMesh::getVertexFaces(std::shared_ptr<Vertex> vertex) const {
-  std::vector<std::shared_ptr<Face>> res;
-  auto halfEdge = vertex->halfEdge;
-  do {
-    res.push_back(halfEdge->face);
-    halfEdge = halfEdge->nextHalfEdge->nextHalfEdge->oppositeHalfEdge;
-  } while (halfEdge != vertex->halfEdge);
-  return res;
+
+int TriMesh::getHalfEdgeFace(int32_t halfEdge) const {
+  return halfEdge / 3;
 }
-const std::vector<std::shared_ptr<Vertex>> &TriMesh::getVertices() const {
-  return vertices;
+
+int32_t TriMesh::getOppositeHalfEdge(int32_t halfEdge) const {
+  return adjacency.opposites[halfEdge];
 }
-const std::vector<std::shared_ptr<Face>> &TriMesh::getFaces() const {
-  return faces;
+
+const std::vector<Vector3i> &TriMesh::getFaceIndices() const {
+  return faceIndices;
 }
 
-Vertex::Vertex(double x, double y, double z) {
-  position = std::make_shared<Vector3d>(std::initializer_list<double>{x, y, z});
-  halfEdge = nullptr;
-  index = -1;
+const HalfEdgeAdjacency &TriMesh::getAdjacency() const {
+  return adjacency;
 }
 
-Vertex::Vertex(const Vector3d &position) {
-  Vertex::position = std::make_shared<Vector3d>(position);
-  halfEdge = nullptr;
-  index = -1;
+const std::vector<Vector3r> &TriMesh::getPositionBuffer() const {
+  return positionBuffer;
+}
+const std::vector<Vector3r> &TriMesh::getNormalBuffer() const {
+  return normalBuffer;
+}
+const std::vector<uint32_t> &TriMesh::getIndexBuffer() const {
+  return indexBuffer;
+}
+const std::vector<Vector3r> &TriMesh::getFacePositionBuffer() const {
+  return facePositionBuffer;
+}
+const std::vector<Vector3r> &TriMesh::getFaceNormalBuffer() const {
+  return faceNormalBuffer;
+}
+const AxisAlignedBox &TriMesh::getBoundingBox() const {
+  return boundingBox;
+}
+const BoundingSphere &TriMesh::getBoundingSphere() const {
+  return boundingSphere;
 }
-Vertex::Vertex(const std::shared_ptr<Vector3d> &position, const std::shared_ptr<Vector3d> &normal) : position(
-    position), normal(normal) {}
@@ -5,54 +5,51 @@
 #ifndef PROG04_INLINEBOOL_TRIMESH_H
 #define PROG04_INLINEBOOL_TRIMESH_H
 
-#include <map>
-#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include "Matrix.h"
-
-struct HalfEdge;
-struct Vertex;
-struct Face;
-
-/// Vertex structure, containing the position, normal and halfEdge informations
-struct Vertex {
-  Vertex(double x, double y, double z);
-  explicit Vertex(const Vector3d &position);
-  Vertex(const std::shared_ptr<Vector3d> &position, const std::shared_ptr<Vector3d> &normal);
-  std::shared_ptr<Vector3d> position;
-  std::shared_ptr<HalfEdge> halfEdge;
-  int index;
-  std::shared_ptr<Vector3d> normal;
-};
-
-/// Face structure, containing the position, normal and halfEdge informations
-struct Face {
-  std::shared_ptr<HalfEdge> halfEdge;
-  std::shared_ptr<Vector3d> normal;
-  std::shared_ptr<Vector3d> position;
-};
-
-/// HalfEdge structure, main structure for the half edge mesh
-struct HalfEdge {
-  std::shared_ptr<Face> face;
-  std::shared_ptr<Vertex> startVertex;
-  std::shared_ptr<HalfEdge> oppositeHalfEdge;
-  std::shared_ptr<HalfEdge> nextHalfEdge;
-};
-
-/// Triangular mesh with half edge data structure.
+#include "MeshIO.h"
+#include "MeshTopology.h"
+#include "LoopSubdivision.h"
+#include "BoundingVolume.h"
+
+/// Triangular mesh with half edge data structure. Vertices, faces and half edges are indices into contiguous arrays:
+/// half edge t * 3 + i of face t runs from its i-th to its (i + 1) % 3-th vertex. The vertex and face buffers are
+/// stored in the precision of the geometry pipeline, while the mesh files, caches and subdivision levels keep double
+/// precision.
 class TriMesh {
  public:
-  /// read and construct a triangular mesh from an .obj file
+  /// read and construct a triangular mesh from an .obj file. Vertex normals given in the file are used as they are.
+  /// The parsed mesh is kept in a binary cache next to the file, which later constructions load instead. Throws
+  /// std::runtime_error if the file cannot be read or is malformed.
   /// \param inputFileName
-  explicit TriMesh(std::string inputFileName);
+  /// \param threadNumber maximum number of threads processing the mesh, 0 uses all hardware threads
+  explicit TriMesh(std::string inputFileName, unsigned int threadNumber = 0);
+
+  /// construct a triangular mesh from geometry in memory. Vertex normals are computed if none are given.
+  /// \param data
+  /// \param adjacency pairing of the half edges of the faces, computed if it does not match them
+  /// \param threadNumber maximum number of threads processing the mesh, 0 uses all hardware threads
+  TriMesh(MeshData &&data, HalfEdgeAdjacency &&adjacency, unsigned int threadNumber = 0);
 
   /// write the triangular mesh to an .obj file.
   /// \param outputFileName
   /// \return
   bool writeToObjFile(std::string outputFileName);
 
-  /// subdivide the triangular mesh
-  void subdivision();
+  /// subdivide the triangular mesh with Loop's scheme. Every level computed is kept, so refining again or going back
+  /// to a coarser level only replaces the current mesh.
+  /// \param levels number of levels to subdivide the current mesh
+  void subdivision(unsigned int levels = 1);
+
+  /// switch to a subdivision level of the loaded mesh, computing it if needed
+  /// \param level 0 for the loaded mesh
+  void setSubdivisionLevel(unsigned int level);
+
+  /// get the current subdivision level
+  /// \return 0 for the loaded mesh
+  unsigned int getSubdivisionLevel() const;
 
   /// get the number of vertices
   /// \return number of vertices
@@ -62,39 +59,95 @@ class TriMesh {
   /// \return number of faces
   int getFaceNumber();
 
-  /// update the vertex and face normals
+  /// get the number of half edges without an opposite half edge
+  /// \return
+  unsigned long getBoundaryEdgeNumber() const;
+
+  /// get the number of directed edges shared by more than one face
+  /// \return
+  unsigned long getNonManifoldEdgeNumber() const;
+
+  /// recompute the face normals and centers, and the vertex normals unless they were loaded from the file
   void updateNormals();
 
-  /// get the neighbor vertices of a face
-  /// \param face
-  /// \return a vector of pointers to the vertex neighbors
-  std::vector<std::shared_ptr<Vertex>> getFaceVertices(std::shared_ptr<Face> face) const;
-  /// get the face neighbors of a vertex
+  /// get the half edges leaving a vertex
   /// \param vertex
-  /// \return a vector of pointers to the face neighbors
-  std::vector<std::shared_ptr<Face>> getVertexFaces(std::shared_ptr<Vertex> vertex) const;
-  /// get the vertices
-  /// \return a vector of pointers to the vertices
-  const std::vector<std::shared_ptr<Vertex>> &getVertices() const;
-  /// get the faces
-  /// \return a vector of pointers to the faces
-  const std::vector<std::shared_ptr<Face>> &getFaces() const;
-
-  /// get the neighbor vertices of a vertex
-  /// \param v
+  /// \return a range of half edge indices
+  VertexRing getVertexRing(int vertex) const;
+  /// get the half edges around a face, in the vertex order of the index buffer
+  /// \param face
+  /// \return a range of half edge indices
+  FaceLoop getFaceLoop(int face) const;
+  /// get the vertex a half edge starts from
+  /// \param halfEdge
+  /// \return
+  int getStartVertex(int32_t halfEdge) const;
+  /// get the vertex a half edge points to
+  /// \param halfEdge
+  /// \return
+  int getEndVertex(int32_t halfEdge) const;
+  /// get the face of a half edge
+  /// \param halfEdge
+  /// \return
+  int getHalfEdgeFace(int32_t halfEdge) const;
+  /// get the half edge running in the opposite direction
+  /// \param halfEdge
+  /// \return -1 on the boundary
+  int32_t getOppositeHalfEdge(int32_t halfEdge) const;
+  /// get the vertex indices of the faces
+  /// \return
+  const std::vector<Vector3i> &getFaceIndices() const;
+  /// get the pairing of the half edges
+  /// \return
+  const HalfEdgeAdjacency &getAdjacency() const;
+
+  /// get the vertex positions as one contiguous array, indexed by the vertex index
+  /// \return
+  const std::vector<Vector3r> &getPositionBuffer() const;
+  /// get the vertex normals as one contiguous array, indexed by the vertex index
+  /// \return
+  const std::vector<Vector3r> &getNormalBuffer() const;
+  /// get the vertex indices of the faces, three consecutive entries per face in the order of getFaceLoop()
+  /// \return
+  const std::vector<uint32_t> &getIndexBuffer() const;
+  /// get the face centers as one contiguous array, indexed by the face index
+  /// \return
+  const std::vector<Vector3r> &getFacePositionBuffer() const;
+  /// get the face normals as one contiguous array, indexed by the face index
+  /// \return
+  const std::vector<Vector3r> &getFaceNormalBuffer() const;
+  /// get the bounding box of the vertices, updated whenever the vertices change
+  /// \return
+  const AxisAlignedBox &getBoundingBox() const;
+  /// get a bounding sphere of the vertices centered at the center of the bounding box
   /// \return
-  std::vector<std::shared_ptr<Vertex>> getVertexVertices(const std::shared_ptr<Vertex> &v);
+  const BoundingSphere &getBoundingSphere() const;
 
  private:
   void initializeHalfEdgeMesh();
-  std::pair<int, int> getEdgePair(const Vector3i &face, int i);
-  std::pair<int, int> getOppositeEdgePair(std::pair<int, int> e);
-  std::vector<std::shared_ptr<Vertex>> vertices;
-  std::vector<std::shared_ptr<Face>> faces;
   std::vector<Vector3i> faceIndices;
-  std::map<std::pair<int, int>, std::shared_ptr<HalfEdge>> halfEdges;
+  /// pairing of the half edges of faceIndices, cleared when the faces change
+  HalfEdgeAdjacency adjacency;
+  /// the half edge the ring of every vertex starts from
+  std::vector<int32_t> vertexHalfEdges;
+  std::vector<Vector3r> positionBuffer;
+  std::vector<Vector3r> normalBuffer;
+  /// flat copies of the topology and face attributes, refreshed whenever the normals are updated
+  std::vector<uint32_t> indexBuffer;
+  std::vector<Vector3r> facePositionBuffer;
+  std::vector<Vector3r> faceNormalBuffer;
+  AxisAlignedBox boundingBox;
+  BoundingSphere boundingSphere;
+  /// every subdivision level computed so far, starting with the loaded mesh once the mesh has been subdivided
+  std::vector<SubdivisionLevel> subdivisionLevels;
+  /// vertex normals given in the file of the loaded mesh
+  std::vector<Vector3r> baseNormals;
+  unsigned int subdivisionLevel;
+  /// maximum number of threads parsing, pairing and subdividing the mesh, 0 for all hardware threads
+  unsigned int threadNumber;
   bool halfEdgeMeshInitialized;
-  bool normalUpdated;
+  /// whether the vertex normals came from the input file and do not need to be computed
+  bool vertexNormalsLoaded;
 };
 
 #endif //PROG04_INLINEBOOL_TRIMESH_H
@@ -3,10 +3,8 @@
 //
 
 #include "Utils.h"
+#include <cmath>
 
-Vector3d Utils::homoDivideVector4d(const Vector4d &rhs) {
-  return Vector3d({rhs(0) / rhs(3), rhs(1) / rhs(3), rhs(2) / rhs(3)});
-}
 Matrix4d Utils::make3dChangeCoordSysMatrix(const Vector3d &u, const Vector3d &v, const Vector3d &w) {
   Matrix4d res(0.);
   res(0, 0) = u(0);
@@ -31,6 +29,44 @@ Matrix4d Utils::make3dTranslateMatrix(const Vector3d &t) {
   }
   return res;
 }
+Matrix4d Utils::make3dRotateMatrix(double angle, const Vector3d &axis) {
+  Vector3d a = axis.normalize();
+  double c = std::cos(angle * M_PI / 180.), s = std::sin(angle * M_PI / 180.);
+  Matrix4d res(0.);
+  for (int r = 0; r < 3; r++) {
+    for (int col = 0; col < 3; col++) {
+      res(r, col) = (1. - c) * a(r) * a(col) + (r == col ? c : 0.);
+    }
+  }
+  res(0, 1) -= s * a(2);
+  res(0, 2) += s * a(1);
+  res(1, 0) += s * a(2);
+  res(1, 2) -= s * a(0);
+  res(2, 0) -= s * a(1);
+  res(2, 1) += s * a(0);
+  res(3, 3) = 1.;
+  return res;
+}
+Matrix4d Utils::make3dScaleMatrix(const Vector3d &s) {
+  Matrix4d res(0.);
+  for (int r = 0; r < 3; r++) {
+    res(r, r) = s(r);
+  }
+  res(3, 3) = 1.;
+  return res;
+}
+Matrix3d Utils::makeNormalMatrix(const Matrix4d &transform) {
+  // the cofactor matrix is the transposed inverse scaled by the determinant
+  Matrix3d res;
+  for (int r = 0; r < 3; r++) {
+    for (int col = 0; col < 3; col++) {
+      int r1 = (r + 1) % 3, r2 = (r + 2) % 3, c1 = (col + 1) % 3, c2 = (col + 2) % 3;
+      res(r, col) = transform(r1, c1) * transform(r2, c2) - transform(r1, c2) * transform(r2, c1);
+    }
+  }
+  double determinant = transform(0, 0) * res(0, 0) + transform(0, 1) * res(0, 1) + transform(0, 2) * res(0, 2);
+  return determinant < 0. ? res * -1. : res;
+}
 Matrix4d Utils::makePerspectiveProjectionMatrix(double n,
                                                 double f,
                                                 double b,
@@ -57,32 +93,3 @@ Matrix4d Utils::makeViewPortTransformMatrix(int nx, int ny) {
   res(3, 3) = 1.;
   return res;
 }
-Vector4d Utils::make4dHomoCoordPoint(const Vector3d &p) {
-  return Vector4d({p(0), p(1), p(2), 1.});
-}
-
-double Utils::computePointLineDistance(const Vector3d &v0, const Vector3d &v1, const Vector3d &v) {
-  return (v0(1) - v1(1)) * v(0) + (v1(0) - v0(0)) * v(1) + v0(0) * v1(1) - v1(0) * v0(1);
-}
-Vector3d Utils::computeBaryCoord(const Vector3d &v0,
-                                 const Vector3d &v1,
-                                 const Vector3d &v2,
-                                 const Vector3d &v) {
-  Vector3d baryCoord;
-  baryCoord(0) = computePointLineDistance(v1, v2, v) / computePointLineDistance(v1, v2, v0);
-  baryCoord(1) = computePointLineDistance(v2, v0, v) / computePointLineDistance(v2, v0, v1);
-  baryCoord(2) = computePointLineDistance(v0, v1, v) / computePointLineDistance(v0, v1, v2);
-  return baryCoord;
-}
-Vector3d Utils::linearInterpolate(const Vector3d &v0,
-                                  const Vector3d &v1,
-                                  const Vector3d &v2,
-                                  const Vector3d &baryCoord) {
-  return v0 * baryCoord(0) + v1 * baryCoord(1) + v2 * baryCoord(2);
-}
-ColorRGB32f Utils::linearInterpolate(const ColorRGB32f &v0,
-                                     const ColorRGB32f &v1,
-                                     const ColorRGB32f &v2,
-                                     const Vector3d &baryCoord) {
-  return v0 * baryCoord(0) + v1 * baryCoord(1) + v2 * baryCoord(2);
-}
@@ -15,7 +15,10 @@ class Utils {
   /// perform homogeneous divide on a 4d vector
   /// \param rhs
   /// \return resulted 3d vector
-  static Vector3d homoDivideVector4d(const Vector4d &rhs);
+  template<typename T>
+  static Matrix<T, 3, 1> homoDivideVector4d(const Matrix<T, 4, 1> &rhs) {
+    return Matrix<T, 3, 1>({rhs(0) / rhs(3), rhs(1) / rhs(3), rhs(2) / rhs(3)});
+  }
   /// construct the transformation matrix to change coordination system
   /// \param u x axis of the new coord system
   /// \param v y axis of the new coord system
@@ -26,6 +29,20 @@ class Utils {
   /// \param t translation vector
   /// \return corresponding transformation matrix
   static Matrix4d make3dTranslateMatrix(const Vector3d &t);
+  /// construct the transformation matrix to rotate around an axis through the origin
+  /// \param angle counterclockwise angle in degrees, looking against the axis
+  /// \param axis rotation axis, not necessarily normalized
+  /// \return corresponding transformation matrix
+  static Matrix4d make3dRotateMatrix(double angle, const Vector3d &axis);
+  /// construct the transformation matrix to scale along the coordinate axes
+  /// \param s scale factors
+  /// \return corresponding transformation matrix
+  static Matrix4d make3dScaleMatrix(const Vector3d &s);
+  /// construct the matrix transforming normals along with an affine transformation, the transposed inverse of its
+  /// linear part up to a positive factor. Transformed normals need to be normalized.
+  /// \param transform affine transformation
+  /// \return
+  static Matrix3d makeNormalMatrix(const Matrix4d &transform);
   /// construct the perspective projection transformation matrix
   /// \param n near plane
   /// \param f far plane
@@ -43,43 +60,23 @@ class Utils {
   /// get the 4d homogeneous point
   /// \param p original point
   /// \return corresponding 4d homogeneous point
-  static Vector4d make4dHomoCoordPoint(const Vector3d &p);
-  /// compute the barycentric coordinate for a point relative to a triangle
-  /// \param v0 vertices of the triangle
-  /// \param v1 vertices of the triangle
-  /// \param v2 vertices of the triangle
-  /// \param v underlying point
-  /// \return the barycentric coordinate
-  static Vector3d computeBaryCoord(const Vector3d &v0,
-                                   const Vector3d &v1,
-                                   const Vector3d &v2,
-                                   const Vector3d &v);
-  /// compute the distance between a point and a line, used to compute barycentric coordinates
-  /// \param v0 points on the line
-  /// \param v1 points on the line
-  /// \param v underlying point
-  /// \return distance between the point and the line
-  static double computePointLineDistance(const Vector3d &v0, const Vector3d &v1, const Vector3d &v);
-  /// linear interpolation on a triangle
-  /// \param v0 vertices of the triangle
-  /// \param v1 vertices of the triangle
-  /// \param v2 vertices of the triangle
-  /// \param baryCoord barycentric coordinate of the point
-  /// \return interpolation result
-  static Vector3d linearInterpolate(const Vector3d &v0,
-                                    const Vector3d &v1,
-                                    const Vector3d &v2,
-                                    const Vector3d &baryCoord);
-  /// linear interpolation on a triangle
+  template<typename T>
+  static Matrix<T, 4, 1> make4dHomoCoordPoint(const Matrix<T, 3, 1> &p) {
+    return Matrix<T, 4, 1>({p(0), p(1), p(2), T(1)});
+  }
+  /// linear interpolation on a triangle, of positions, normals or colors
   /// \param v0 vertices of the triangle
   /// \param v1 vertices of the triangle
   /// \param v2 vertices of the triangle
   /// \param baryCoord barycentric coordinate of the point
   /// \return interpolation result
-  static ColorRGB32f linearInterpolate(const ColorRGB32f &v0,
-                                       const ColorRGB32f &v1,
-                                       const ColorRGB32f &v2,
-                                       const Vector3d &baryCoord);
+  template<typename T, typename U>
+  static Matrix<T, 3, 1> linearInterpolate(const Matrix<T, 3, 1> &v0,
+                                           const Matrix<T, 3, 1> &v1,
+                                           const Matrix<T, 3, 1> &v2,
+                                           const Matrix<U, 3, 1> &baryCoord) {
+    return v0 * baryCoord(0) + v1 * baryCoord(1) + v2 * baryCoord(2);
+  }
 };
 
 #endif //PROG05_MATRIXUTILS_H
@@ -0,0 +1,347 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+// Render benchmark: times every stage of the renderer on scene files, over several thread numbers, and the loading
+// and processing of mesh files, and reports them as JSON or CSV to compare builds.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Renderer.h"
+#include "MeshCache.h"
+
+#ifndef BENCHMARK_DATA_DIRECTORY
+#define BENCHMARK_DATA_DIRECTORY "."
+#endif
+
+namespace {
+const char *const kDefaultScenes[] = {"kitten.txt", "myscene.txt", "ballring.txt", "2spheres1.txt", "2spheres2.txt",
+                                      "2spheres3.txt", "pointlights.txt"};
+const char *const kDefaultMeshes[] = {"kitten.obj", "sphere1.obj", "sphere2.obj", "torus4.obj"};
+
+struct Options {
+  bool csv = false;
+  /// output file, empty for the standard output
+  std::string output;
+  /// measured runs of every benchmark, the median of which is reported
+  unsigned int repeat = 5;
+  /// thread numbers the scenes are rendered with
+  std::vector<unsigned int> threadNumbers;
+  /// subdivision levels of the meshes
+  unsigned int subdivisionLevels = 3;
+  std::vector<std::string> sceneFileNames;
+  std::vector<std::string> meshFileNames;
+};
+
+/// One measurement: the median time of a stage of a benchmark on an input
+struct Result {
+  std::string benchmark;
+  std::string input;
+  unsigned int threads;
+  std::string stage;
+  double seconds;
+  /// number of units processed by the stage, 0 if the stage has no unit
+  unsigned long count;
+  std::string unit;
+};
+
+void printUsage(const char *program) {
+  std::cout << "usage: " << program << " [options] [scene.txt ...] [mesh.obj ...]\n"
+            << "  -f, --format <json|csv>  output format (default json)\n"
+            << "  -o, --output <file>      output file (default: the standard output)\n"
+            << "  -r, --repeat <n>         measured runs of every benchmark, the median is reported (default 5)\n"
+            << "  -t, --threads <list>     comma separated thread numbers to render and process meshes with\n"
+            << "                           (default: 1, 2, 4, ... up to the hardware threads)\n"
+            << "  -l, --levels <n>         subdivision levels of the meshes (default 3)\n"
+            << "  -h, --help               show this help\n"
+            << "Without scene or mesh files, the scenes and meshes bundled with the renderer are measured.\n";
+}
+
+bool parseCount(const std::string &value, unsigned int &count) {
+  char *end = nullptr;
+  long parsed = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || parsed < 0) {
+    return false;
+  }
+  count = static_cast<unsigned int>(parsed);
+  return true;
+}
+
+bool endsWith(const std::string &value, const std::string &suffix) {
+  return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// \return false if the program should exit, with exitCode set
+bool parseOptions(int argc, char **argv, Options &options, int &exitCode) {
+  exitCode = 1;
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "-h" || argument == "--help") {
+      printUsage(argv[0]);
+      exitCode = 0;
+      return false;
+    } else if ((argument == "-f" || argument == "--format") && hasValue) {
+      std::string format = argv[++i];
+      if (format != "json" && format != "csv") {
+        std::cerr << "unknown output format " << format << std::endl;
+        return false;
+      }
+      options.csv = format == "csv";
+    } else if ((argument == "-o" || argument == "--output") && hasValue) {
+      options.output = argv[++i];
+    } else if ((argument == "-r" || argument == "--repeat") && hasValue) {
+      if (!parseCount(argv[++i], options.repeat) || options.repeat == 0) {
+        std::cerr << "invalid repeat number " << argv[i] << std::endl;
+        return false;
+      }
+    } else if ((argument == "-t" || argument == "--threads") && hasValue) {
+      std::istringstream values(argv[++i]);
+      std::string value;
+      while (std::getline(values, value, ',')) {
+        unsigned int threadNumber;
+        if (!parseCount(value, threadNumber) || threadNumber == 0) {
+          std::cerr << "invalid thread number " << value << std::endl;
+          return false;
+        }
+        options.threadNumbers.push_back(threadNumber);
+      }
+    } else if ((argument == "-l" || argument == "--levels") && hasValue) {
+      if (!parseCount(argv[++i], options.subdivisionLevels)) {
+        std::cerr << "invalid subdivision level number " << argv[i] << std::endl;
+        return false;
+      }
+    } else if (!argument.empty() && argument[0] == '-') {
+      std::cerr << "unknown option " << argument << std::endl;
+      printUsage(argv[0]);
+      return false;
+    } else if (endsWith(argument, ".obj")) {
+      options.meshFileNames.push_back(argument);
+    } else {
+      options.sceneFileNames.push_back(argument);
+    }
+  }
+  if (options.sceneFileNames.empty() && options.meshFileNames.empty()) {
+    for (auto scene: kDefaultScenes) {
+      options.sceneFileNames.push_back(std::string(BENCHMARK_DATA_DIRECTORY) + "/" + scene);
+    }
+    for (auto mesh: kDefaultMeshes) {
+      options.meshFileNames.push_back(std::string(BENCHMARK_DATA_DIRECTORY) + "/" + mesh);
+    }
+  }
+  if (options.threadNumbers.empty()) {
+    unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threadNumber = 1; threadNumber < hardwareThreads; threadNumber *= 2) {
+      options.threadNumbers.push_back(threadNumber);
+    }
+    options.threadNumbers.push_back(hardwareThreads);
+  }
+  return true;
+}
+
+double getMedian(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  auto middle = values.size() / 2;
+  return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.;
+}
+
+/// time a function several times
+/// \param repeat
+/// \param prepare called before every run, not timed
+/// \param run timed function
+/// \return median time in seconds
+template<typename Prepare, typename Run>
+double timeMedian(unsigned int repeat, Prepare prepare, Run run) {
+  std::vector<double> times;
+  for (unsigned int i = 0; i < repeat; i++) {
+    prepare();
+    auto start = std::chrono::steady_clock::now();
+    run();
+    times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return getMedian(times);
+}
+
+/// render a scene with every thread number and time the stages of the renderer
+bool benchmarkScene(const Options &options, const std::string &sceneFileName,
+                    const std::shared_ptr<ModelLibrary> &modelLibrary, std::vector<Result> &results) {
+  if (!std::ifstream(sceneFileName)) {
+    std::cerr << sceneFileName << ": cannot open the scene file" << std::endl;
+    return false;
+  }
+  auto scene = std::make_shared<Scene>(sceneFileName, modelLibrary);
+  Renderer renderer(scene);
+  renderer.setVerbose(false);
+  renderer.setShadingPolicy(Renderer::PHONG_SHADING);
+  renderer.setShadingPolicyMask(Renderer::ALL_SHADING_POLICIES);
+  auto imageSize = scene->getMainCamera().getImageSize();
+  auto pixelNumber = static_cast<unsigned long>(imageSize.first) * static_cast<unsigned long>(imageSize.second);
+  std::string input = sceneFileName.substr(sceneFileName.find_last_of("/\\") + 1);
+  for (auto threadNumber: options.threadNumbers) {
+    renderer.setThreadNumber(threadNumber);
+    // the first render allocates the buffers and is not measured
+    renderer.invalidateImages();
+    renderer.renderForDisplay();
+    std::vector<StageTimes> runs;
+    std::vector<double> totals;
+    for (unsigned int i = 0; i < options.repeat; i++) {
+      renderer.invalidateImages();
+      auto start = std::chrono::steady_clock::now();
+      renderer.renderForDisplay();
+      totals.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+      runs.push_back(renderer.getStageTimes());
+    }
+    const RenderStats &stats = renderer.getRenderStats();
+    const PrimitiveCounters &counters = stats.primitives;
+    auto addStage = [&](const char *stage, double StageTimes::*time, unsigned long count, const char *unit) {
+      std::vector<double> times;
+      for (const auto &run: runs) {
+        times.push_back(run.*time);
+      }
+      results.push_back({"render", input, threadNumber, stage, getMedian(times), count, unit});
+    };
+    addStage("prepareBuffers", &StageTimes::prepareBuffers, pixelNumber, "pixel");
+    addStage("prepareMatrices", &StageTimes::prepareMatrices, 0, "");
+    addStage("cullObjects", &StageTimes::cullObjects, counters.submitted, "triangle");
+    addStage("processVertices", &StageTimes::processVertices, counters.submitted, "triangle");
+    addStage("rasterize", &StageTimes::rasterize, counters.rasterized, "triangle");
+    addStage("fragmentShading", &StageTimes::fragmentShading, stats.fragments, "fragment");
+    addStage("convert", &StageTimes::convert, pixelNumber, "pixel");
+    results.push_back({"render", input, threadNumber, "total", getMedian(totals), counters.rasterized, "triangle"});
+  }
+  return true;
+}
+
+/// time the loading, half edge mesh construction, normal update and subdivision of a mesh file. The parallel stages
+/// are timed with every thread number, the normal update runs on one thread.
+bool benchmarkMesh(const Options &options, const std::string &meshFileName, std::vector<Result> &results) {
+  MeshData data;
+  std::string error;
+  if (!MeshIO::readObjFile(meshFileName, data, error)) {
+    std::cerr << error << std::endl;
+    return false;
+  }
+  std::string input = meshFileName.substr(meshFileName.find_last_of("/\\") + 1);
+  auto faceNumber = data.faces.size();
+  auto addStage = [&](unsigned int threadNumber, const std::string &stage, double seconds, unsigned long count) {
+    results.push_back({"mesh", input, threadNumber, stage, seconds, count, "triangle"});
+  };
+  auto nothing = []() {};
+
+  TriMesh mesh(MeshData(data), HalfEdgeAdjacency(), 1);
+  addStage(1, "updateNormals", timeMedian(options.repeat, nothing, [&]() { mesh.updateNormals(); }), faceNumber);
+  bool cacheEnabled = MeshCache::isEnabled();
+  for (auto threadNumber: options.threadNumbers) {
+    MeshData parsed;
+    addStage(threadNumber, "parseObj", timeMedian(options.repeat, [&]() { parsed = MeshData(); }, [&]() {
+      MeshIO::readObjFile(meshFileName, parsed, error, threadNumber);
+    }), faceNumber);
+    MeshCache::setEnabled(false);
+    addStage(threadNumber, "load", timeMedian(options.repeat, nothing, [&]() {
+      TriMesh loaded(meshFileName, threadNumber);
+    }), faceNumber);
+    MeshCache::setEnabled(true);
+    { TriMesh loaded(meshFileName, threadNumber); }
+    addStage(threadNumber, "loadCached", timeMedian(options.repeat, nothing, [&]() {
+      TriMesh loaded(meshFileName, threadNumber);
+    }), faceNumber);
+    MeshCache::setEnabled(cacheEnabled);
+
+    // the half edge mesh of geometry in memory, including the first normal update of initializeHalfEdgeMesh()
+    MeshData copy;
+    addStage(threadNumber, "initializeHalfEdgeMesh", timeMedian(options.repeat, [&]() { copy = data; }, [&]() {
+      TriMesh initialized(std::move(copy), HalfEdgeAdjacency(), threadNumber);
+    }), faceNumber);
+    for (unsigned int level = 1; level <= options.subdivisionLevels; level++) {
+      std::unique_ptr<TriMesh> subdivided;
+      double seconds = timeMedian(options.repeat, [&]() {
+        subdivided.reset(new TriMesh(MeshData(data), HalfEdgeAdjacency(mesh.getAdjacency()), threadNumber));
+      }, [&]() { subdivided->subdivision(level); });
+      addStage(threadNumber, "subdivision" + std::to_string(level), seconds,
+               static_cast<unsigned long>(subdivided->getFaceNumber()));
+    }
+  }
+  return true;
+}
+
+/// quote a string for JSON and CSV, which only contain file names and identifiers here
+std::string quote(const std::string &value) {
+  std::string quoted = "\"";
+  for (char c: value) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void writeResults(const Options &options, const std::vector<Result> &results, std::ostream &out) {
+  out.precision(9);
+  if (options.csv) {
+    out << "benchmark,input,threads,stage,seconds,count,unit,nsPerUnit\n";
+    for (const auto &result: results) {
+      out << result.benchmark << "," << quote(result.input) << "," << result.threads << "," << result.stage << ","
+          << result.seconds << "," << result.count << "," << result.unit << ",";
+      if (result.count > 0) {
+        out << result.seconds * 1e9 / result.count;
+      }
+      out << "\n";
+    }
+    return;
+  }
+  out << "{\"hardwareThreads\": " << std::thread::hardware_concurrency() << ", \"repeat\": " << options.repeat
+      << ", \"results\": [\n";
+  for (unsigned long i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    out << "  {\"benchmark\": " << quote(result.benchmark) << ", \"input\": " << quote(result.input)
+        << ", \"threads\": " << result.threads << ", \"stage\": " << quote(result.stage) << ", \"seconds\": "
+        << result.seconds << ", \"count\": " << result.count << ", \"unit\": " << quote(result.unit)
+        << ", \"nsPerUnit\": ";
+    if (result.count > 0) {
+      out << result.seconds * 1e9 / result.count;
+    } else {
+      out << "null";
+    }
+    out << (i + 1 < results.size() ? "},\n" : "}\n");
+  }
+  out << "]}\n";
+}
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  int exitCode;
+  if (!parseOptions(argc, argv, options, exitCode)) {
+    return exitCode;
+  }
+  std::vector<Result> results;
+  bool succeeded = true;
+  auto modelLibrary = std::make_shared<ModelLibrary>();
+  for (const auto &sceneFileName: options.sceneFileNames) {
+    std::cerr << "rendering " << sceneFileName << std::endl;
+    succeeded = benchmarkScene(options, sceneFileName, modelLibrary, results) && succeeded;
+  }
+  for (const auto &meshFileName: options.meshFileNames) {
+    std::cerr << "processing " << meshFileName << std::endl;
+    succeeded = benchmarkMesh(options, meshFileName, results) && succeeded;
+  }
+  if (options.output.empty()) {
+    writeResults(options, results, std::cout);
+  } else {
+    std::ofstream out(options.output);
+    writeResults(options, results, out);
+    if (!out) {
+      std::cerr << "cannot write " << options.output << std::endl;
+      return 1;
+    }
+  }
+  return succeeded ? 0 : 1;
+}
@@ -0,0 +1,485 @@
+//
+// Created by Jiang Kairong on 10/17/26.
+//
+// Headless renderer: renders scene files to PPM images from the command line, without SDL or a display.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FramePipeline.h"
+#include "Trace.h"
+
+namespace {
+const char *const kPolicyNames[Renderer::SHADING_POLICY_NUMBER] = {"flat", "gouraud", "phong"};
+
+struct Options {
+  /// bit (1 << policy) set for every shading policy written
+  unsigned int policies = 1u << Renderer::PHONG_SHADING;
+  /// output file for a single image, or output directory, empty to write next to the scene files
+  std::string output;
+  /// threads of every job, 0 to share the hardware threads between the jobs
+  unsigned int threadNumber = 0;
+  /// scenes rendered at the same time
+  unsigned int jobNumber = 1;
+  /// whether the frames of the camera paths are rendered instead of the main cameras
+  bool animate = false;
+  /// frames of an animation rendered at the same time
+  unsigned int framesInFlight = FramePipeline::DEFAULT_FRAMES_IN_FLIGHT;
+  /// Chrome trace file of the timeline of the batch, empty for no trace
+  std::string traceFileName;
+  /// file the statistics of every render are written to as JSON lines, "-" for the standard output, empty for none
+  std::string statsFileName;
+  /// directory of the reference images every written image is compared with, empty for no comparison
+  std::string compareDirectory;
+  /// lowest peak signal to noise ratio in dB of an image matching its reference
+  double minPsnr = 40.;
+  bool quiet = false;
+  std::vector<std::string> sceneFileNames;
+};
+
+void printUsage(const char *program) {
+  std::cout << "usage: " << program << " [options] scene.txt [scene.txt ...]\n"
+            << "  -p, --policy <list>   shading policies to write, comma separated flat, gouraud, phong or all\n"
+            << "                        (default phong). All of them are rendered in one pass.\n"
+            << "  -o, --output <path>   output .ppm file for a single image, or existing output directory.\n"
+            << "                        Images are written next to the scene files by default.\n"
+            << "  -t, --threads <n>     threads of every job (default: the hardware threads shared by the jobs)\n"
+            << "  -j, --jobs <n>        scenes rendered at the same time (default 1)\n"
+            << "  -a, --animate         render every frame of the camera paths of the scenes, numbered after the\n"
+            << "                        scene file names\n"
+            << "      --in-flight <n>   frames of an animation rendered at the same time, sharing the threads of\n"
+            << "                        the job (default " << FramePipeline::DEFAULT_FRAMES_IN_FLIGHT << ")\n"
+            << "      --trace <file>    write the timeline of the batch as a Chrome trace, needs a build with the\n"
+            << "                        RASTERIZER_TRACE CMake option\n"
+            << "  -s, --stats <file>    write the statistics of every render as JSON lines to a file, or to the\n"
+            << "                        standard output with -, moving the other output to the standard error\n"
+            << "      --compare <dir>   compare every written image with the image of the same name in a directory,\n"
+            << "                        failing on a missing or different sized reference or a low PSNR\n"
+            << "      --min-psnr <dB>   lowest PSNR of an image matching its reference (default 40)\n"
+            << "  -q, --quiet           only report errors and the summary\n"
+            << "  -h, --help            show this help\n"
+            << "Meshes used by several scenes of the batch are loaded once.\n";
+}
+
+bool parsePolicies(const std::string &value, unsigned int &policies) {
+  policies = 0;
+  std::istringstream names(value);
+  std::string name;
+  while (std::getline(names, name, ',')) {
+    if (name == "all") {
+      policies |= Renderer::ALL_SHADING_POLICIES;
+      continue;
+    }
+    auto found = std::find(std::begin(kPolicyNames), std::end(kPolicyNames), name);
+    if (found == std::end(kPolicyNames)) {
+      return false;
+    }
+    policies |= 1u << (found - std::begin(kPolicyNames));
+  }
+  return policies != 0;
+}
+
+bool parseCount(const std::string &value, unsigned int &count) {
+  char *end = nullptr;
+  long parsed = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || parsed < 0) {
+    return false;
+  }
+  count = static_cast<unsigned int>(parsed);
+  return true;
+}
+
+/// \return false if the program should exit, with exitCode set
+bool parseOptions(int argc, char **argv, Options &options, int &exitCode) {
+  exitCode = 1;
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "-h" || argument == "--help") {
+      printUsage(argv[0]);
+      exitCode = 0;
+      return false;
+    } else if (argument == "-q" || argument == "--quiet") {
+      options.quiet = true;
+    } else if ((argument == "-s" || argument == "--stats") && hasValue) {
+      options.statsFileName = argv[++i];
+    } else if (argument == "-a" || argument == "--animate") {
+      options.animate = true;
+    } else if ((argument == "-p" || argument == "--policy") && hasValue) {
+      if (!parsePolicies(argv[++i], options.policies)) {
+        std::cerr << "unknown shading policy in " << argv[i] << std::endl;
+        return false;
+      }
+    } else if ((argument == "-o" || argument == "--output") && hasValue) {
+      options.output = argv[++i];
+    } else if ((argument == "-t" || argument == "--threads") && hasValue) {
+      if (!parseCount(argv[++i], options.threadNumber)) {
+        std::cerr << "invalid thread number " << argv[i] << std::endl;
+        return false;
+      }
+    } else if ((argument == "-j" || argument == "--jobs") && hasValue) {
+      if (!parseCount(argv[++i], options.jobNumber) || options.jobNumber == 0) {
+        std::cerr << "invalid job number " << argv[i] << std::endl;
+        return false;
+      }
+    } else if (argument == "--trace" && hasValue) {
+      options.traceFileName = argv[++i];
+      if (!Trace::isCompiledIn()) {
+        std::cerr << "tracing is not compiled in, configure with -DRASTERIZER_TRACE=ON" << std::endl;
+        return false;
+      }
+    } else if (argument == "--compare" && hasValue) {
+      options.compareDirectory = argv[++i];
+    } else if (argument == "--min-psnr" && hasValue) {
+      char *end = nullptr;
+      options.minPsnr = std::strtod(argv[++i], &end);
+      if (*end != '\0' || end == argv[i]) {
+        std::cerr << "invalid PSNR " << argv[i] << std::endl;
+        return false;
+      }
+    } else if (argument == "--in-flight" && hasValue) {
+      if (!parseCount(argv[++i], options.framesInFlight) || options.framesInFlight == 0) {
+        std::cerr << "invalid number of frames in flight " << argv[i] << std::endl;
+        return false;
+      }
+    } else if (!argument.empty() && argument[0] == '-') {
+      std::cerr << "unknown option " << argument << std::endl;
+      printUsage(argv[0]);
+      return false;
+    } else {
+      options.sceneFileNames.push_back(argument);
+    }
+  }
+  if (options.sceneFileNames.empty()) {
+    printUsage(argv[0]);
+    return false;
+  }
+  bool singleImage = options.sceneFileNames.size() == 1 && (options.policies & (options.policies - 1)) == 0
+      && !options.animate;
+  auto extension = options.output.size() >= 4 ? options.output.substr(options.output.size() - 4) : "";
+  if (extension == ".ppm" && !singleImage) {
+    std::cerr << "an output file only takes a single scene, shading policy and frame, use a directory instead"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// \param frame frame of an animation, -1 for a still image
+std::string getOutputFileName(const Options &options, const std::string &sceneFileName, int policy, int frame) {
+  bool severalPolicies = (options.policies & (options.policies - 1)) != 0;
+  std::string suffix = severalPolicies ? std::string(".") + kPolicyNames[policy] + ".ppm" : ".ppm";
+  if (frame >= 0) {
+    std::string number = std::to_string(frame);
+    suffix = "." + std::string(number.size() < 4 ? 4 - number.size() : 0, '0') + number + suffix;
+  }
+  if (options.output.empty()) {
+    return sceneFileName + suffix;
+  }
+  if (options.output.size() >= 4 && options.output.substr(options.output.size() - 4) == ".ppm") {
+    return options.output;
+  }
+  // the scene file name without its directory and extension, in the output directory
+  auto nameBegin = sceneFileName.find_last_of("/\\") + 1;
+  auto nameEnd = sceneFileName.find_last_of('.');
+  if (nameEnd == std::string::npos || nameEnd < nameBegin) {
+    nameEnd = sceneFileName.size();
+  }
+  std::string directory = options.output;
+  if (directory.back() != '/' && directory.back() != '\\') {
+    directory += '/';
+  }
+  return directory + sceneFileName.substr(nameBegin, nameEnd - nameBegin) + suffix;
+}
+
+/// compare a written image with the image of the same file name in the reference directory
+/// \param report description of the differences, or the reason of the failure
+/// \return false if the reference is missing, has another size or differs too much
+bool compareImage(const Options &options, const std::string &outputFileName, const Image8i &image,
+                  std::string &report) {
+  std::string referenceFileName = options.compareDirectory;
+  if (referenceFileName.back() != '/' && referenceFileName.back() != '\\') {
+    referenceFileName += '/';
+  }
+  referenceFileName += outputFileName.substr(outputFileName.find_last_of("/\\") + 1);
+  auto reference = ImageUtils::readPpm(referenceFileName);
+  if (!reference) {
+    report = "cannot read the reference " + referenceFileName;
+    return false;
+  }
+  if (reference->rows() != image.rows() || reference->cols() != image.cols()) {
+    report = outputFileName + " and the reference " + referenceFileName + " differ in size";
+    return false;
+  }
+  ImageDifference difference = ImageUtils::compareImages(image, *reference);
+  std::ostringstream out;
+  out << outputFileName << " differs from " << referenceFileName << " in " << difference.pixels
+      << " pixels, by up to " << difference.maxChannel << ", PSNR " << difference.psnr << " dB";
+  if (difference.psnr < options.minPsnr) {
+    out << ", below " << options.minPsnr << " dB";
+  }
+  report = out.str();
+  return difference.psnr >= options.minPsnr;
+}
+
+/// results of one scene of the batch
+struct JobResult {
+  /// times in seconds
+  double loading = 0.;
+  double rendering = 0.;
+  unsigned long frames = 0;
+  /// line reporting the scene, or the reason of the failure
+  std::string report;
+  /// JSON lines of the statistics of the renders, when requested
+  std::string stats;
+};
+
+/// get the statistics of a render as a JSON line
+/// \param frame frame of an animation, -1 for a still image
+std::string getStatsLine(const std::string &sceneFileName, int frame, const RenderStats &stats) {
+  std::string line = "{\"scene\": \"";
+  for (char c: sceneFileName) {
+    if (c == '"' || c == '\\') {
+      line += '\\';
+    }
+    line += c;
+  }
+  line += "\", ";
+  if (frame >= 0) {
+    line += "\"frame\": " + std::to_string(frame) + ", ";
+  }
+  return line + "\"stats\": " + stats.toJson() + "}\n";
+}
+
+/// load, render and write one scene
+/// \return false on failure, with the reason in the report of the result
+bool renderScene(const Options &options, const std::string &sceneFileName,
+                 const std::shared_ptr<ModelLibrary> &modelLibrary, unsigned int threadNumber,
+                 JobResult &result) {
+  using Clock = std::chrono::steady_clock;
+  if (!std::ifstream(sceneFileName)) {
+    result.report = sceneFileName + ": cannot open the scene file";
+    return false;
+  }
+  auto start = Clock::now();
+  Renderer renderer(std::make_shared<Scene>(sceneFileName, modelLibrary));
+  renderer.setVerbose(false);
+  renderer.setThreadNumber(threadNumber);
+  int firstPolicy = 0;
+  while (!(options.policies & 1u << firstPolicy)) {
+    firstPolicy++;
+  }
+  renderer.setShadingPolicy(firstPolicy);
+  renderer.setShadingPolicyMask(options.policies);
+  auto loaded = Clock::now();
+  renderer.renderForDisplay();
+  auto rendered = Clock::now();
+  result.loading = std::chrono::duration<double>(loaded - start).count();
+  result.rendering = std::chrono::duration<double>(rendered - loaded).count();
+  result.frames = 1;
+  if (!options.statsFileName.empty()) {
+    result.stats = getStatsLine(sceneFileName, -1, renderer.getRenderStats());
+  }
+
+  std::ostringstream out;
+  out << sceneFileName << ": loaded in " << result.loading << " s, rendered in " << result.rendering << " s";
+  std::string comparisons;
+  for (int policy = 0; policy < Renderer::SHADING_POLICY_NUMBER; policy++) {
+    if (!(options.policies & 1u << policy)) {
+      continue;
+    }
+    std::string outputFileName = getOutputFileName(options, sceneFileName, policy, -1);
+    if (!ImageUtils::writePpm(*renderer.getImage(policy), outputFileName)) {
+      result.report = sceneFileName + ": cannot write " + outputFileName;
+      return false;
+    }
+    out << ", " << outputFileName;
+    if (!options.compareDirectory.empty()) {
+      std::string comparison;
+      if (!compareImage(options, outputFileName, *renderer.getImage(policy), comparison)) {
+        result.report = sceneFileName + ": " + comparison;
+        return false;
+      }
+      comparisons += "\n  " + comparison;
+    }
+  }
+  result.report = out.str() + comparisons;
+  return true;
+}
+
+/// load one scene, render the frames of its camera path through a frame pipeline and write them as they finish
+/// \return false on failure, with the reason in the report of the result
+bool renderAnimation(const Options &options, const std::string &sceneFileName,
+                     const std::shared_ptr<ModelLibrary> &modelLibrary, unsigned int threadNumber,
+                     JobResult &result) {
+  using Clock = std::chrono::steady_clock;
+  if (!std::ifstream(sceneFileName)) {
+    result.report = sceneFileName + ": cannot open the scene file";
+    return false;
+  }
+  auto start = Clock::now();
+  auto scene = std::make_shared<Scene>(sceneFileName, modelLibrary);
+  unsigned int frameThreadNumber = threadNumber == 0 ? 0 : std::max(1u, threadNumber / options.framesInFlight);
+  FramePipeline pipeline(scene, options.framesInFlight, frameThreadNumber);
+  int firstPolicy = 0;
+  while (!(options.policies & 1u << firstPolicy)) {
+    firstPolicy++;
+  }
+  for (unsigned int r = 0; r < pipeline.getRendererNumber(); r++) {
+    pipeline.getRenderer(r).setShadingPolicy(firstPolicy);
+    pipeline.getRenderer(r).setShadingPolicyMask(options.policies);
+  }
+  // a scene without camera path is a single frame seen by the main camera
+  int frameNumber = std::max(1, scene->getCameraPath().getFrameNumber());
+  auto loaded = Clock::now();
+  std::string firstFileName, lastFileName, comparisons;
+  try {
+    pipeline.render(0, frameNumber, [&](int frame, const std::vector<std::shared_ptr<Image8i>> &images,
+                                        const RenderStats &stats) {
+      if (!options.statsFileName.empty()) {
+        result.stats += getStatsLine(sceneFileName, frame, stats);
+      }
+      for (int policy = 0; policy < Renderer::SHADING_POLICY_NUMBER; policy++) {
+        if (!(options.policies & 1u << policy)) {
+          continue;
+        }
+        lastFileName = getOutputFileName(options, sceneFileName, policy, frame);
+        if (!ImageUtils::writePpm(*images[policy], lastFileName)) {
+          throw std::runtime_error("cannot write " + lastFileName);
+        }
+        if (!options.compareDirectory.empty()) {
+          std::string comparison;
+          if (!compareImage(options, lastFileName, *images[policy], comparison)) {
+            throw std::runtime_error(comparison);
+          }
+          comparisons += "\n  " + comparison;
+        }
+        if (firstFileName.empty()) {
+          firstFileName = lastFileName;
+        }
+      }
+    });
+  } catch (const std::exception &e) {
+    result.report = sceneFileName + ": " + e.what();
+    return false;
+  }
+  auto rendered = Clock::now();
+  result.loading = std::chrono::duration<double>(loaded - start).count();
+  result.rendering = std::chrono::duration<double>(rendered - loaded).count();
+  result.frames = static_cast<unsigned long>(frameNumber);
+
+  std::ostringstream out;
+  out << sceneFileName << ": loaded in " << result.loading << " s, " << frameNumber << " frames rendered in "
+      << result.rendering << " s, " << frameNumber / result.rendering << " frames per second, " << firstFileName;
+  if (lastFileName != firstFileName) {
+    out << " to " << lastFileName;
+  }
+  result.report = out.str() + comparisons;
+  return true;
+}
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  int exitCode;
+  if (!parseOptions(argc, argv, options, exitCode)) {
+    return exitCode;
+  }
+  auto jobNumber = std::min(options.jobNumber, static_cast<unsigned int>(options.sceneFileNames.size()));
+  unsigned int threadNumber = options.threadNumber;
+  if (threadNumber == 0 && jobNumber > 1) {
+    threadNumber = std::max(1u, std::thread::hardware_concurrency() / jobNumber);
+  }
+
+  // the statistics are kept apart from the reports, so that their stream only holds JSON lines
+  std::ofstream statsFile;
+  bool statsToStandardOutput = options.statsFileName == "-";
+  if (!options.statsFileName.empty() && !statsToStandardOutput) {
+    statsFile.open(options.statsFileName, std::ios::out | std::ios::trunc);
+    if (!statsFile) {
+      std::cerr << "cannot write " << options.statsFileName << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &stats = statsToStandardOutput ? std::cout : statsFile;
+  std::ostream &out = statsToStandardOutput ? std::cerr : std::cout;
+
+  Trace::setEnabled(!options.traceFileName.empty());
+  // the jobs take the scenes in order and share the loaded models, which load with the threads of a job
+  auto modelLibrary = std::make_shared<ModelLibrary>(threadNumber);
+  std::atomic<unsigned long> nextScene(0);
+  std::atomic<unsigned long> failures(0);
+  std::mutex outputMutex;
+  JobResult total;
+  auto start = std::chrono::steady_clock::now();
+  auto runJob = [&]() {
+    Trace::setThreadName("job");
+    for (auto s = nextScene++; s < options.sceneFileNames.size(); s = nextScene++) {
+      JobResult result;
+      auto render = options.animate ? renderAnimation : renderScene;
+      bool succeeded;
+      try {
+        TRACE_SCOPE("scene");
+        succeeded = render(options, options.sceneFileNames[s], modelLibrary, threadNumber, result);
+      } catch (const std::exception &e) {
+        // a failing scene fails its job only, the other scenes of the batch still render
+        result = JobResult();
+        result.report = options.sceneFileNames[s] + ": " + e.what();
+        succeeded = false;
+      }
+      std::lock_guard<std::mutex> lock(outputMutex);
+      total.loading += result.loading;
+      total.rendering += result.rendering;
+      total.frames += result.frames;
+      if (!succeeded) {
+        failures++;
+        std::cerr << result.report << std::endl;
+      } else if (!options.quiet) {
+        out << result.report << std::endl;
+      }
+      stats << result.stats << std::flush;
+    }
+  };
+  std::vector<std::thread> jobs;
+  for (unsigned int j = 1; j < jobNumber; j++) {
+    jobs.emplace_back(runJob);
+  }
+  runJob();
+  for (auto &job: jobs) {
+    job.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  auto sceneNumber = options.sceneFileNames.size() - failures;
+  auto jobThreadNumber = threadNumber == 0 ? std::thread::hardware_concurrency() : threadNumber;
+  out << sceneNumber << " of " << options.sceneFileNames.size() << " scenes rendered in " << seconds
+      << " s by " << jobNumber << " jobs of " << jobThreadNumber << " threads, "
+      << modelLibrary->getModelNumber() << " meshes loaded, " << total.frames / seconds
+      << " frames per second" << std::endl;
+  out << "summed over the jobs: loading " << total.loading << " s, rendering " << total.rendering << " s" << std::endl;
+  if (!options.traceFileName.empty()) {
+    Trace::setEnabled(false);
+    if (!Trace::writeChromeTrace(options.traceFileName)) {
+      std::cerr << "cannot write " << options.traceFileName << std::endl;
+      return 1;
+    }
+  }
+  if (statsFile.is_open()) {
+    statsFile.close();
+    if (!statsFile) {
+      std::cerr << "cannot write " << options.statsFileName << std::endl;
+      return 1;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -83,6 +83,20 @@ void renderTexture(SDL_Texture *tex, SDL_Renderer *ren, int x, int y) {
 }
 
 
+///
+/// Show the culling counters of the last render in the window title
+///
+/// \param window The window to update
+/// \param renderer The renderer whose counters are shown
+///
+void showCullingCounters(SDL_Window *window, const Renderer &renderer) {
+  const PrimitiveCounters &counters = renderer.getPrimitiveCounters();
+  std::string title = "Rasterizer - occluded " + std::to_string(counters.objectsOccluded) + " objects, "
+      + std::to_string(counters.occlusionCulled) + " triangles, levels of detail saved "
+      + std::to_string(counters.levelOfDetailReduced) + " triangles";
+  SDL_SetWindowTitle(window, title.c_str());
+}
+
 ///
 /// Main function.  Initializes an SDL window, renderer, and texture,
 /// and then goes into a loop to listen to events and draw the texture.
@@ -102,11 +116,11 @@ int main(int argc, char **argv) {
   string inputFileName = argv[1];
 
   Renderer rasterizeRenderer(inputFileName);
+  // render every policy in the first pass, so that switching with f, g and p only shows the stored images
+  rasterizeRenderer.setShadingPolicyMask(Renderer::ALL_SHADING_POLICIES);
 
   auto result = rasterizeRenderer.renderForDisplay();
 
-  ofstream out;
-
   //Integers specifying the width (number of columns) and height (number
   //of rows) of the image
   int num_cols = static_cast<int>(result->cols());
@@ -125,6 +139,7 @@ int main(int argc, char **argv) {
     SDL_Quit();
     return 1;
   }
+  showCullingCounters(window, rasterizeRenderer);
   SDL_Renderer
       *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
   if (renderer == nullptr) {
@@ -215,23 +230,26 @@ int main(int argc, char **argv) {
           case SDLK_i:break;
           case SDLK_n:break;
           case SDLK_m:break;
-          case SDLK_b:break;
+          case SDLK_b:rasterizeRenderer.setBackFaceCullingEnabled(!rasterizeRenderer.isBackFaceCullingEnabled());
+            cout << "back-face culling " << (rasterizeRenderer.isBackFaceCullingEnabled() ? "on" : "off") << endl;
+            delete[] data;
+            result = rasterizeRenderer.renderForDisplay();
+            data = ImageUtils::getRawData(*result);
+            break;
+          case SDLK_l:rasterizeRenderer.setLevelOfDetailEnabled(!rasterizeRenderer.isLevelOfDetailEnabled());
+            cout << "levels of detail " << (rasterizeRenderer.isLevelOfDetailEnabled() ? "on" : "off") << endl;
+            delete[] data;
+            result = rasterizeRenderer.renderForDisplay();
+            data = ImageUtils::getRawData(*result);
+            break;
           case SDLK_s:cout << "saving image to ppm" << endl;
-            out.open(inputFileName + ".ppm", std::ios::out | std::ios::trunc | std::ios::binary);
-            out << "P6" << std::endl;
-            out << std::to_string(num_cols).data() << " " << std::to_string(num_rows).data() << std::endl;
-            out << std::to_string(255).data() << std::endl;
-            for (int i = 0; i < num_rows; i++) {
-              for (int j = 0; j < num_cols; j++) {
-                out << (*result)(i, j)(0);
-                out << (*result)(i, j)(1);
-                out << (*result)(i, j)(2);
-              }
+            if (!ImageUtils::writePpm(*result, inputFileName + ".ppm")) {
+              cout << "cannot write " << inputFileName << ".ppm" << endl;
             }
-            out.close();
             break;
           default:break;
         }
+        showCullingCounters(window, rasterizeRenderer);
       } else if (event.type == SDL_MOUSEBUTTONUP) {
         if (event.button.button == SDL_BUTTON_LEFT)
           leftMouseButtonDown = false;